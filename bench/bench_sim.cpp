@@ -0,0 +1,303 @@
+// Headless simulation benchmark (target: ramster_bench_sim).
+//
+// Loads every level in levels/, spawns all of its enemies up front, drives the ball with a
+// fixed input script and times the gameplay systems frame by frame. No window, GL context,
+// textures or audio, so it runs on a headless Linux box. Run it from the build directory
+// (levels are read from LEVEL_DIR_FILEPATH, same as the game).
+//
+//   ramster_bench_sim [--frames N] [--out FILE] [level.tmj ...]
+//
+// Writes mean / p50 / p99 / max milliseconds per system per level as JSON (default bench_sim.json).
+// Each level is also run with its spawns repeated up to AI_STRESS_ENEMIES, once with the AI worker
+// threads and once without; the two must end in the same state or the bench exits with an error.
+// It also exits with an error if the flow field never published a search in the stress run, or
+// the live field got older than two searches while the player moved on.
+
+#include <box2d/box2d.h>
+#include <json/json.h>
+
+// stdlib
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+
+// internal
+#include "ai_system.hpp"
+#include "physics_system.hpp"
+#include "world_init.hpp"
+#include "level_loader.hpp"
+#include "terrain.hpp"
+#include "rope.hpp"
+#include "boids.hpp"
+#include "input_log.hpp"
+#include "bench_samples.hpp"
+#include "tinyECS/registry.hpp"
+
+using Clock = std::chrono::high_resolution_clock;
+
+const float BENCH_FRAME_MS = 1000.f / 60.f;
+// enough enemies that the AI decision phase really runs on the worker threads
+const int AI_STRESS_ENEMIES = 2 * AI_PARALLEL_MIN_ENEMIES;
+
+static double elapsed_ms(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Scripted input, the same every run: roll right, back off left, roll right again,
+// with a jump every 1.5 s when the ball isn't already moving vertically.
+static void apply_script(b2BodyId ball, int frame)
+{
+	int phase = frame % 600;
+	b2Vec2 force = { phase < 240 || phase >= 300 ? BALL_GROUNDED_MOVEMENT_FORCE : -BALL_GROUNDED_MOVEMENT_FORCE, 0.f };
+	b2Body_ApplyForce(ball, force, b2Body_GetPosition(ball), true);
+
+	if (frame % 90 == 45 && fabs(b2Body_GetLinearVelocity(ball).y) < 1.f) {
+		b2Body_ApplyLinearImpulseToCenter(ball, b2Vec2{ 0.f, BALL_JUMP_IMPULSE }, true);
+	}
+}
+
+struct LevelRun
+{
+	bool loaded = false;
+	int enemies = 0;
+	int chain_segments = 0;
+	uint64_t checksum = 0;
+	// flow field: searches published, and the oldest the live field got while the player moved on
+	int flow_searches = 0;
+	int flow_max_field_age = 0;
+	int flow_field_age_bound = 0;
+	std::map<std::string, Samples> systems;
+	Json::Value micro;
+};
+
+// Load a level into a fresh world, step it `frames` times and time each system.
+// The level's spawns are repeated, in order, until there are at least min_enemies.
+static LevelRun run_level(const std::string &level, int frames, int ai_extra_threads, bool micro, int min_enemies = 0)
+{
+	LevelRun run;
+
+	registry.clear_all_components();
+
+	b2WorldDef worldDef = b2DefaultWorldDef();
+	b2WorldId worldId = b2CreateWorld(&worldDef);
+	b2World_SetGravity(worldId, b2Vec2{ 0.f, GRAVITY });
+
+	Entity screen = createCurrentScreen();
+	registry.currentScreen.get(screen).current_screen = "PLAYING";
+
+	auto loadStart = Clock::now();
+	std::vector<LevelSpawn> spawns;
+	run.loaded = load_level_file(level, worldId, spawns);
+	if (!run.loaded || registry.players.entities.empty()) {
+		std::cerr << "bench: could not load " << level << std::endl;
+		b2DestroyWorld(worldId);
+		run.loaded = false;
+		return run;
+	}
+	create_static_terrain(worldId, (float)WORLD_WIDTH_PX, (float)WORLD_HEIGHT_PX);
+	createBackgroundLayer();
+
+	// spawn everything now instead of waiting for the player to reach each trigger
+	for (const LevelSpawn &spawn : spawns) {
+		createEnemyGroup(worldId, spawn.enemy_type, spawn.quantity, spawn.spawn_location, spawn.patrol_point_a, spawn.patrol_point_b);
+	}
+	for (size_t i = 0; !spawns.empty() && (int)registry.enemies.entities.size() < min_enemies; i = (i + 1) % spawns.size()) {
+		const LevelSpawn &spawn = spawns[i];
+		createEnemyGroup(worldId, spawn.enemy_type, std::max(spawn.quantity, 1), spawn.spawn_location, spawn.patrol_point_a, spawn.patrol_point_b);
+	}
+	run.enemies = (int)registry.enemies.entities.size();
+	for (const TerrainChain &chain : level_terrain_chains) {
+		run.chain_segments += (int)chain.points.size() - (chain.isLoop ? 0 : 1);
+	}
+	run.systems["load"].add(elapsed_ms(loadStart));
+
+	AISystem ai(worldId);
+	ai.setWorkerThreads(ai_extra_threads);
+	PhysicsSystem physics(worldId);
+	Entity player = registry.players.entities[0];
+	b2BodyId ball = registry.physicsBodies.get(player).bodyId;
+
+	for (int frame = 0; frame < frames; frame++) {
+		auto frameStart = Clock::now();
+
+		apply_script(ball, frame);
+
+		auto start = Clock::now();
+		ai.step(BENCH_FRAME_MS);
+		run.systems["ai"].add(elapsed_ms(start));
+		run.systems["ai_decide"].add(ai.decide_us / 1000.0);
+		run.systems["ai_apply"].add(ai.apply_us / 1000.0);
+		run.systems["ai_swarm"].add(ai.swarm_step_us / 1000.0);
+		run.flow_max_field_age = std::max(run.flow_max_field_age, ai.flowField.field_age_ticks);
+
+		start = Clock::now();
+		physics.step(BENCH_FRAME_MS);
+		run.systems["physics"].add(elapsed_ms(start));
+
+		// WorldSystem::handle_collisions normally consumes these
+		start = Clock::now();
+		registry.collisions.clear();
+		run.systems["ecs_collisions_clear"].add(elapsed_ms(start));
+
+		run.systems["frame"].add(elapsed_ms(frameStart));
+	}
+	run.checksum = world_checksum();
+	run.flow_searches = ai.flowField.searches_completed;
+	run.flow_field_age_bound = 2 * ai.flowField.max_search_ticks(FLOW_FIELD_CELLS_PER_TICK) + 1;
+
+	if (micro) {
+		vec2 playerPos = registry.motions.get(player).position;
+
+		// rope: 64 segments hanging from 300 px above the ball, with terrain collision
+		Rope rope;
+		vec2 anchor = playerPos + vec2(0.f, 300.f);
+		rope_init(rope, playerPos, anchor, GRAPPLE_ROPE_SEGMENTS);
+		Samples ropeSamples;
+		for (int i = 0; i < 600; i++) {
+			auto start = Clock::now();
+			rope_step(rope, worldId, playerPos, anchor, 300.f, BENCH_FRAME_MS / 1000.f);
+			ropeSamples.add(elapsed_ms(start));
+		}
+		run.micro["rope_step"] = ropeSamples.summary();
+	}
+
+	resetGrapplePool();
+	b2DestroyWorld(worldId);
+	registry.clear_all_components();
+	return run;
+}
+
+// flocking kernel on a synthetic 1000-boid swarm (no Box2D bodies, so apply is skipped)
+static Json::Value bench_boids(int count)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	BoidsBuffer boids;
+	for (int i = 0; i < count; i++) {
+		boids.add(b2_nullBodyId, vec2(2000.f + unit(rng) * 3000.f, 500.f + unit(rng) * 1500.f), vec2(unit(rng) * 100.f, unit(rng) * 100.f));
+	}
+	Samples samples;
+	for (int i = 0; i < 200; i++) {
+		auto start = Clock::now();
+		boids_build_neighbours(boids);
+		boids_compute(boids, vec2(3000.f, 1000.f), 37.5f);
+		samples.add(elapsed_ms(start));
+	}
+	Json::Value out = samples.summary();
+	out["boids"] = count;
+	return out;
+}
+
+int main(int argc, char *argv[])
+{
+	int frames = 600;
+	std::string outPath = "bench_sim.json";
+	std::vector<std::string> levels;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			frames = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+			outPath = argv[++i];
+		}
+		else {
+			levels.push_back(argv[i]);
+		}
+	}
+
+	// same physics units as the game
+	b2SetLengthUnitsPerMeter(100.0f);
+
+	if (levels.empty()) {
+		for (const auto &entry : std::filesystem::directory_iterator(LEVEL_DIR_FILEPATH)) {
+			if (entry.path().extension() == ".tmj") {
+				levels.push_back(entry.path().filename().string());
+			}
+		}
+		std::sort(levels.begin(), levels.end());
+	}
+	if (levels.empty()) {
+		std::cerr << "bench: no levels found in " << LEVEL_DIR_FILEPATH << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	Json::Value root;
+	root["frames"] = frames;
+	root["frame_ms"] = BENCH_FRAME_MS;
+	root["ai_worker_threads"] = AI_WORKER_THREADS;
+
+	bool all_deterministic = true;
+	bool all_flow_fields_ok = true;
+	for (const std::string &level : levels) {
+		LevelRun run = run_level(level, frames, AI_WORKER_THREADS, true);
+		if (!run.loaded) {
+			root["levels"][level]["error"] = "failed to load";
+			continue;
+		}
+
+		// threaded and single-threaded runs of the stress setup: both must end in exactly the same
+		// state, and the decide phase times show the speedup. Nothing in the AI keys off entity ids
+		// (the MID stagger uses the spawn order), so the runs differing in ids doesn't matter.
+		LevelRun stress = run_level(level, frames, AI_WORKER_THREADS, false, AI_STRESS_ENEMIES);
+		LevelRun stress_serial = run_level(level, frames, 0, false, AI_STRESS_ENEMIES);
+		const bool deterministic = stress.checksum == stress_serial.checksum;
+		all_deterministic = all_deterministic && deterministic;
+		const bool flow_field_ok = stress.flow_searches > 0 && stress.flow_max_field_age <= stress.flow_field_age_bound;
+		all_flow_fields_ok = all_flow_fields_ok && flow_field_ok;
+
+		Json::Value &out = root["levels"][level];
+		out["enemies"] = run.enemies;
+		out["chain_segments"] = run.chain_segments;
+		for (auto &[name, samples] : run.systems) {
+			out["systems"][name] = samples.summary();
+		}
+		out["micro"] = run.micro;
+
+		Json::Value &threading = out["ai_threading"];
+		threading["enemies"] = stress.enemies;
+		threading["decide_mean_1_thread"] = stress_serial.systems["ai_decide"].summary()["mean"];
+		threading["decide_mean_n_threads"] = stress.systems["ai_decide"].summary()["mean"];
+		threading["deterministic"] = deterministic;
+
+		Json::Value &flow = out["flow_field"];
+		flow["searches_completed"] = stress.flow_searches;
+		flow["max_field_age_ticks"] = stress.flow_max_field_age;
+		flow["field_age_ticks_bound"] = stress.flow_field_age_bound;
+
+		std::cout << "bench: " << level << " (" << run.enemies << " enemies, " << run.chain_segments << " chain segments) ai "
+				  << out["systems"]["ai"]["mean"].asDouble() << " ms, physics "
+				  << out["systems"]["physics"]["mean"].asDouble() << " ms, deterministic with "
+				  << stress.enemies << " enemies " << (deterministic ? "yes" : "NO") << ", flow field searches "
+				  << stress.flow_searches << " (field up to " << stress.flow_max_field_age << " of "
+				  << stress.flow_field_age_bound << " ticks old)" << std::endl;
+	}
+
+	root["micro"]["boids_1000"] = bench_boids(1000);
+
+	std::ofstream file(outPath);
+	if (!file) {
+		std::cerr << "bench: cannot write " << outPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	Json::StreamWriterBuilder writer;
+	writer["indentation"] = "  ";
+	file << Json::writeString(writer, root) << std::endl;
+	std::cout << "bench: wrote " << outPath << std::endl;
+
+	if (!all_deterministic) {
+		std::cerr << "bench: threaded and single-threaded AI runs diverged" << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (!all_flow_fields_ok) {
+		std::cerr << "bench: the flow field stopped publishing searches in a stress run" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,342 @@
+// Stress level generator (target: ramster_gen_level).
+//
+// Writes a Tiled map in the same shape as the hand-made levels (a tile layer plus a "Chain"
+// object layer) but with configurable amounts of content, so the benchmarks can show how
+// load time, physics, AI and rendering scale. The same seed and options always produce the
+// same file (the generator uses its own RNG: <random> distributions differ between standard libraries).
+//
+//   ramster_gen_level [--seed N] [--width TILES] [--height TILES] [--ground-segments N]
+//                     [--platforms N] [--platform-vertices N] [--grapple-points N]
+//                     [--spawns N] [--enemies-per-spawn N] [--out FILE]
+//
+// Sizes are in world tiles (TILE_WIDTH px). The default output is
+// LEVEL_DIR_FILEPATH/stress/stress_<seed>.tmj, which ramster_bench_sim loads as "stress/stress_<seed>.tmj".
+
+#include <json/json.h>
+
+// stdlib
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// internal
+#include "common.hpp"
+
+struct GeneratorOptions
+{
+	uint64_t seed = 1;
+	int width_tiles = 400;
+	int height_tiles = 40;
+	int ground_segments = 4000;
+	int platforms = 300;
+	int platform_vertices = 8;
+	int grapple_points = 300;
+	int spawns = 100;
+	int enemies_per_spawn = 5;
+	std::string out;
+};
+
+// splitmix64: tiny, seedable and identical everywhere
+class LevelRng
+{
+public:
+	explicit LevelRng(uint64_t seed) : state(seed) {}
+
+	uint64_t next()
+	{
+		uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	// [0, 1)
+	float unit() { return (float)(next() >> 40) / (float)(1ull << 24); }
+	float range(float lo, float hi) { return lo + (hi - lo) * unit(); }
+	int range_int(int lo, int hi) { return lo + (int)(next() % (uint64_t)(hi - lo + 1)); }
+
+private:
+	uint64_t state;
+};
+
+class LevelWriter
+{
+public:
+	LevelWriter(const GeneratorOptions &options) : options(options), rng(options.seed)
+	{
+		width_px = (float)(options.width_tiles * TILE_WIDTH);
+		height_px = (float)(options.height_tiles * TILE_HEIGHT);
+		objects = Json::Value(Json::arrayValue);
+
+		// a few octaves of rolling hills in the bottom third, fixed per seed
+		for (int i = 0; i < 3; i++) {
+			hill_phase[i] = rng.range(0.f, 6.2831853f);
+		}
+	}
+
+	Json::Value build()
+	{
+		add_boundary();
+		add_ground();
+		add_platforms();
+		add_grapple_points();
+		add_spawns();
+		add_ball_and_goal();
+
+		// Tiled counts 64 px tiles, the game halves that into TILE_WIDTH px world tiles
+		const int mapWidth = options.width_tiles * 2;
+		const int mapHeight = options.height_tiles * 2;
+
+		Json::Value tiles;
+		tiles["id"] = 1;
+		tiles["name"] = "Tile Layer 1";
+		tiles["type"] = "tilelayer";
+		tiles["width"] = mapWidth;
+		tiles["height"] = mapHeight;
+		tiles["opacity"] = 1;
+		tiles["visible"] = true;
+		tiles["x"] = 0;
+		tiles["y"] = 0;
+		tiles["data"] = Json::Value(Json::arrayValue);
+		for (int i = 0; i < mapWidth * mapHeight; i++) {
+			tiles["data"].append(0);
+		}
+
+		Json::Value chain;
+		chain["id"] = 2;
+		chain["name"] = "Chain";
+		chain["type"] = "objectgroup";
+		chain["draworder"] = "topdown";
+		chain["opacity"] = 1;
+		chain["visible"] = true;
+		chain["x"] = 0;
+		chain["y"] = 0;
+		chain["objects"] = objects;
+
+		Json::Value map;
+		map["compressionlevel"] = -1;
+		map["width"] = mapWidth;
+		map["height"] = mapHeight;
+		map["tilewidth"] = TILE_WIDTH / 2;
+		map["tileheight"] = TILE_HEIGHT / 2;
+		map["infinite"] = false;
+		map["orientation"] = "orthogonal";
+		map["renderorder"] = "right-down";
+		map["type"] = "map";
+		map["version"] = "1.10";
+		map["tiledversion"] = "1.11.2";
+		map["nextlayerid"] = 3;
+		map["nextobjectid"] = next_id;
+		map["tilesets"] = Json::Value(Json::arrayValue);
+		map["layers"].append(tiles);
+		map["layers"].append(chain);
+		map["properties"].append(property("generator_seed", std::to_string(options.seed)));
+		return map;
+	}
+
+	int segment_count = 0;
+
+private:
+	const GeneratorOptions &options;
+	LevelRng rng;
+	float width_px, height_px;
+	float hill_phase[3];
+	Json::Value objects;
+	int next_id = 1;
+
+	// Tiled y grows downwards; these helpers take world (y up) coordinates
+	Json::Value object(const std::string &name, float x, float y)
+	{
+		Json::Value obj;
+		obj["id"] = next_id++;
+		obj["name"] = name;
+		obj["type"] = "";
+		obj["rotation"] = 0;
+		obj["visible"] = true;
+		obj["width"] = 0;
+		obj["height"] = 0;
+		obj["x"] = x;
+		obj["y"] = height_px - y;
+		return obj;
+	}
+
+	void add_point(const std::string &name, vec2 position)
+	{
+		Json::Value obj = object(name, position.x, position.y);
+		obj["point"] = true;
+		objects.append(obj);
+	}
+
+	// points are world coordinates; the object origin is the first point
+	void add_shape(const std::string &name, const char *kind, const std::vector<vec2> &points)
+	{
+		Json::Value obj = object(name, points[0].x, points[0].y);
+		for (const vec2 &p : points) {
+			Json::Value point;
+			point["x"] = p.x - points[0].x;
+			point["y"] = points[0].y - p.y;
+			obj[kind].append(point);
+		}
+		objects.append(obj);
+	}
+
+	static Json::Value property(const std::string &name, const std::string &value)
+	{
+		Json::Value prop;
+		prop["name"] = name;
+		prop["type"] = "string";
+		prop["value"] = value;
+		return prop;
+	}
+
+	float ground_height(float x) const
+	{
+		float t = x / width_px * 6.2831853f;
+		float h = 0.18f + 0.06f * sinf(t * 3.f + hill_phase[0]) + 0.03f * sinf(t * 11.f + hill_phase[1]) +
+				  0.015f * sinf(t * 37.f + hill_phase[2]);
+		return h * height_px;
+	}
+
+	// Walls are one-sided chains, so the winding decides which side collides: the boundary
+	// runs clockwise (solid from inside), solids run counter-clockwise (solid from outside).
+	void add_boundary()
+	{
+		add_shape("boundary", JSON_POLYGON_ATTR.c_str(),
+				  { vec2(width_px, height_px), vec2(width_px, 0.f), vec2(0.f, 0.f), vec2(0.f, height_px) });
+		segment_count += 4;
+	}
+
+	void add_ground()
+	{
+		// jittered, so the loader's collinear welding can't merge the segments away
+		const int segments = std::max(2, options.ground_segments);
+		const float step = width_px / segments;
+		std::vector<vec2> points = { vec2(0.f, 0.f), vec2(width_px, 0.f) };
+		for (int i = segments; i >= 0; i--) {
+			float x = i * step;
+			points.push_back(vec2(x, ground_height(x) + rng.range(-6.f, 6.f)));
+		}
+		add_shape("ground", JSON_POLYGON_ATTR.c_str(), points);
+		segment_count += (int)points.size();
+	}
+
+	void add_platforms()
+	{
+		const int vertices = std::max(3, options.platform_vertices);
+		for (int i = 0; i < options.platforms; i++) {
+			float x = rng.range(TILE_WIDTH * 3.f, width_px - TILE_WIDTH * 3.f);
+			float floor = ground_height(x) + TILE_HEIGHT * 2.f;
+			float y = rng.range(floor, std::max(floor, height_px - TILE_HEIGHT * 2.f));
+			float radius = rng.range(TILE_WIDTH * 0.4f, TILE_WIDTH * 1.2f);
+
+			// a lumpy convex-ish blob, counter-clockwise
+			std::vector<vec2> points;
+			for (int v = 0; v < vertices; v++) {
+				float angle = 6.2831853f * v / vertices;
+				float r = radius * rng.range(0.7f, 1.f);
+				points.push_back(vec2(x + cosf(angle) * r * 1.6f, y + sinf(angle) * r * 0.5f));
+			}
+			add_shape("platform", JSON_POLYGON_ATTR.c_str(), points);
+			segment_count += vertices;
+		}
+	}
+
+	vec2 air_position(float min_clearance)
+	{
+		float x = rng.range(TILE_WIDTH * 2.f, width_px - TILE_WIDTH * 2.f);
+		float floor = ground_height(x) + min_clearance;
+		return vec2(x, rng.range(floor, std::max(floor, height_px - TILE_HEIGHT)));
+	}
+
+	void add_grapple_points()
+	{
+		for (int i = 0; i < options.grapple_points; i++) {
+			add_point("grapple_point", air_position(TILE_HEIGHT * 2.f));
+		}
+	}
+
+	// SZ_<id> trigger zone (bottom-left -> top-right polyline) plus ENEMY_<type>_<count>_<id>:
+	// a point for swarm/common enemies, a patrol polyline for obstacles
+	void add_spawns()
+	{
+		const char types[] = { 'C', 'S', 'O' };
+		const int perSpawn = std::max(1, options.enemies_per_spawn);
+		for (int id = 1; id <= options.spawns; id++) {
+			// spread triggers along the level so they fire progressively as the ball advances
+			float zoneX = width_px * (0.05f + 0.9f * (id - 0.5f) / options.spawns);
+			float zoneY = ground_height(zoneX);
+			add_shape("SZ_" + std::to_string(id), JSON_POLYLINE_ATTR.c_str(),
+					  { vec2(zoneX, zoneY), vec2(zoneX + TILE_WIDTH, height_px - TILE_HEIGHT) });
+
+			char type = types[rng.range_int(0, 2)];
+			std::string name = std::string("ENEMY_") + type + "_" + std::to_string(type == 'O' ? 1 : perSpawn) + "_" + std::to_string(id);
+			float enemyX = std::min(width_px - TILE_WIDTH * 2.f, zoneX + rng.range(TILE_WIDTH * 2.f, TILE_WIDTH * 8.f));
+			vec2 enemy = vec2(enemyX, ground_height(enemyX) + TILE_HEIGHT * rng.range(1.5f, 4.f));
+			if (type == 'O') {
+				add_shape(name, JSON_POLYLINE_ATTR.c_str(), { enemy, enemy + vec2(0.f, TILE_HEIGHT * 3.f) });
+			}
+			else {
+				add_point(name, enemy);
+			}
+		}
+	}
+
+	void add_ball_and_goal()
+	{
+		float startX = TILE_WIDTH * 1.5f;
+		add_point(JSON_BALL_SPAWNPOINT, vec2(startX, ground_height(startX) + TILE_HEIGHT));
+
+		float goalX = width_px - TILE_WIDTH * 2.f;
+		float goalY = ground_height(goalX) + TILE_HEIGHT * 0.5f;
+		add_shape("goal", JSON_POLYLINE_ATTR.c_str(), { vec2(goalX, goalY), vec2(goalX + TILE_WIDTH, goalY + TILE_HEIGHT) });
+	}
+};
+
+int main(int argc, char *argv[])
+{
+	GeneratorOptions options;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		const char *arg = argv[i];
+		const char *value = argv[i + 1];
+		if (strcmp(arg, "--seed") == 0) options.seed = strtoull(value, nullptr, 10);
+		else if (strcmp(arg, "--width") == 0) options.width_tiles = std::max(8, atoi(value));
+		else if (strcmp(arg, "--height") == 0) options.height_tiles = std::max(8, atoi(value));
+		else if (strcmp(arg, "--ground-segments") == 0) options.ground_segments = atoi(value);
+		else if (strcmp(arg, "--platforms") == 0) options.platforms = std::max(0, atoi(value));
+		else if (strcmp(arg, "--platform-vertices") == 0) options.platform_vertices = atoi(value);
+		else if (strcmp(arg, "--grapple-points") == 0) options.grapple_points = std::max(0, atoi(value));
+		else if (strcmp(arg, "--spawns") == 0) options.spawns = std::max(0, atoi(value));
+		else if (strcmp(arg, "--enemies-per-spawn") == 0) options.enemies_per_spawn = atoi(value);
+		else if (strcmp(arg, "--out") == 0) options.out = value;
+		else {
+			std::cerr << "gen_level: unknown option " << arg << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	if (options.out.empty()) {
+		std::filesystem::create_directories(LEVEL_DIR_FILEPATH + "stress");
+		options.out = LEVEL_DIR_FILEPATH + "stress/stress_" + std::to_string(options.seed) + ".tmj";
+	}
+
+	LevelWriter writer(options);
+	Json::Value map = writer.build();
+
+	std::ofstream out(options.out);
+	if (!out.is_open()) {
+		std::cerr << "gen_level: could not write " << options.out << std::endl;
+		return EXIT_FAILURE;
+	}
+	Json::StreamWriterBuilder builder;
+	builder["indentation"] = "";
+	builder["precision"] = 7;
+	out << Json::writeString(builder, map);
+
+	std::cout << "gen_level: wrote " << options.out << " (" << writer.segment_count << " chain segments, "
+			  << options.platforms << " platforms, " << options.grapple_points << " grapple points, "
+			  << options.spawns << " spawn pairs)" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,16 @@
+#version 330
+
+// From vertex shader
+in vec2 texcoord;
+in vec4 tint;
+
+// Application data
+uniform sampler2D sampler0;
+
+// Output color
+layout(location = 0) out vec4 color;
+
+void main()
+{
+	color = tint * texture(sampler0, texcoord);
+}
@@ -0,0 +1,32 @@
+#version 330
+
+// Per-vertex attributes (the SPRITE quad)
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec2 in_texcoord;
+
+// Per-instance attributes, see SpriteInstance in render_system.hpp
+layout(location = 2) in vec4 in_transform_linear;      // columns 0 and 1 of the transform
+layout(location = 3) in vec2 in_transform_translation; // column 2
+layout(location = 4) in vec4 in_uv_rect;               // u0, v0, u1, v1
+layout(location = 5) in vec4 in_tint;
+
+// Passed to fragment shader
+out vec2 texcoord;
+out vec4 tint;
+
+// Application data
+uniform mat3 projection;
+
+void main()
+{
+	mat3 transform = mat3(
+		vec3(in_transform_linear.xy, 0.0),
+		vec3(in_transform_linear.zw, 0.0),
+		vec3(in_transform_translation, 1.0));
+
+	texcoord = mix(in_uv_rect.xy, in_uv_rect.zw, in_texcoord);
+	tint = in_tint;
+
+	vec3 pos = projection * transform * vec3(in_position.xy, 1.0);
+	gl_Position = vec4(pos.xy, in_position.z, 1.0);
+}
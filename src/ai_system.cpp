@@ -1,6 +1,16 @@
 #include <iostream>
 #include "ai_system.hpp"
 #include "world_init.hpp"
+#include <chrono>
+
+AISystem::AISystem(b2WorldId worldId) : worldId(worldId)
+{
+}
+
+void AISystem::setWorkerThreads(int extra_threads)
+{
+	workers.resize(extra_threads);
+}
 
 void AISystem::step(float elapsed_ms)
 {
@@ -37,12 +47,16 @@ void AISystem::step(float elapsed_ms)
 					// Default triggers if obstacle not moving
 					1aa_e. Keep moving in current direction.
 
-			1_b. NON-OBSTACLE enemies:
+			1_b. NON-OBSTACLE enemies: **NOTE: only pursue while aware of the player, i.e. they've had line of sight
+			     within the last ENEMY_AWARENESS_MEMORY_MS. Unaware COMMON enemies stand still; unaware SWARM enemies keep flocking.
 
 				1b_a. If freeze-timer is above 0, decrement timer by elapsed time and exit.
 
 					1ba_a. COMMON enemies:
 
+						Follow the flow field toward the player (it routes around terrain).
+						If the field has no route yet:
+
 						1baa_a. If player is to the left, move left.
 
 						2baa_b. If player is to the right, move right.
@@ -51,337 +65,337 @@ void AISystem::step(float elapsed_ms)
 
 						[Excluded. This condition is effectively covered by 1bab_b.] 1bab_a. IF TOO CLOSE TO THE GROUND, PULL UP!
 
-						1bab_a. Pursue the player.  **Note that this takes precedence. Collision avoidance is applied later.
-
-						1bab_b. IF TOO CLOSE TO ANOTHER ENTITY THAT IS NOT THE PLAYER, move away from that entity.
-
-						1bab_c. IF TOO FAR FROM SWARM, rejoin swarm.
+						Handled as a flock after the loop (boids.cpp). Every swarm enemy blends:
+						- pursuit of the player,
+						- separation from swarm neighbours that are too close,
+						- cohesion toward the local swarm centre (rejoining the swarm),
+						- alignment with the neighbours' velocity,
+						- a pull up when skimming the ground.
 
 	*/
 
-	// Box2D physics
-	b2Vec2 nonjump_movement_force = { 0, 0 };
-	b2Vec2 jump_impulse = { 0, 0 }; // not needed for now, here for future use
-	const float forceMagnitude = ENEMY_GROUNDED_MOVEMENT_FORCE; 
-
-	// Different enemy types have different weights, so we'll need to apply some corrections here to compensate.
-
-	const float swarmPursuit_forceMagnitude = forceMagnitude * 0.08;
-	// The swarm applies corrections AFTER pursuing the player. To make sure player pursuit takes precedence, we'll make this force smaller so it corrects itself but will still
-	// mainly pursue the player while doing so.
-	const float swarmCorrection_forceMagnitude = swarmPursuit_forceMagnitude * 0.25; 
-
-	const float obstacle_forceMagnitude = forceMagnitude * 200;
-
-	const float jumpImpulseMagnitude = ENEMY_JUMP_IMPULSE; // not needed for now, here for future use
-
 	// Get player and figure out player coords
 	auto& player_registry = registry.players;
-	Player& player = player_registry.components[0];
 	Entity playerEntity = player_registry.entities[0];
 	Motion& playerMotion = registry.motions.get(playerEntity);
 
 	// Player position
 	float player_posX = playerMotion.position[0];
-	float player_posY = playerMotion.position[1]; // we wouldn't need this for now, here for future use.
+	float player_posY = playerMotion.position[1];
 
 	// Get enemy entities
 	auto& enemy_registry = registry.enemies; //list of enemy entities stored in here
+	const int enemy_count = (int)enemy_registry.entities.size();
+
+	// New level: re-rasterise the terrain and drop old sight results. Then advance the search toward the player (time-sliced).
+	if (flowFieldTerrainVersion != level_terrain_version) {
+		flowField.build_grid((float)WORLD_WIDTH_PX, (float)WORLD_HEIGHT_PX, level_terrain_chains);
+		lineOfSight.clear();
+		flowFieldTerrainVersion = level_terrain_version;
+	}
+	flowField.update(playerMotion.position, FLOW_FIELD_CELLS_PER_TICK);
 
+	// Answer the sight checks queued last step
+	lineOfSight.process(worldId, playerMotion.position, elapsed_ms, LOS_RAY_BUDGET);
+	ai_los_rays_last_step = lineOfSight.rays_last_process;
 
-	// Iterate over each enemy and implement basic logic as commented above.
-	for (int i = 0; i < enemy_registry.entities.size(); i++) {
+	// Level of detail: only NEAR enemies think every tick
+	tick++;
 
-		// Figure out enemy details
+	// PHASE 0 (main thread): pack what the decisions need, so phase 1 never touches the registry maps or Box2D.
+	auto decideStart = std::chrono::high_resolution_clock::now();
+	enemyInputs.resize(enemy_count);
+	enemyDecisions.resize(enemy_count);
+	for (int i = 0; i < enemy_count; i++) {
 		Entity enemyEntity = enemy_registry.entities[i];
-		Motion& enemyMotion = registry.motions.get(enemyEntity);
-		Enemy& enemyComponent = registry.enemies.get(enemyEntity);
+		EnemyInput& input = enemyInputs[i];
+		input.id = (unsigned int)enemyEntity;
+		input.bodyId = registry.physicsBodies.get(enemyEntity).bodyId;
+		input.position = registry.motions.get(enemyEntity).position;
+		b2Vec2 velocity = b2Body_GetLinearVelocity(input.bodyId);
+		input.velocity = vec2(velocity.x, velocity.y);
+	}
 
-		// Get Box2D Speed
-		b2BodyId enemy_id = registry.physicsBodies.get(enemyEntity).bodyId;
-		b2Vec2 enemy_velocity = b2Body_GetLinearVelocity(enemy_id);
+	// PHASE 1 (parallel): every enemy's decision only reads its own input/component and shared read-only state.
+	const vec2 player_position = playerMotion.position;
+	auto decideRange = [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			decide(enemyInputs[i], enemy_registry.components[i], player_position, elapsed_ms, enemyDecisions[i]);
+		}
+	};
+	if (enemy_count >= AI_PARALLEL_MIN_ENEMIES) {
+		workers.parallel_for(enemy_count, decideRange);
+	}
+	else {
+		decideRange(0, enemy_count);
+	}
+	auto applyStart = std::chrono::high_resolution_clock::now();
+	decide_us = std::chrono::duration<float, std::micro>(applyStart - decideStart).count();
+
+	// PHASE 2 (main thread, entity order): commit state, queue sight checks, hand forces to Box2D.
+	// Active (unfrozen) swarm enemies are collected here and steered together afterwards.
+	boids.clear();
+	boidEntities.clear();
+	for (int band = 0; band < AI_LOD_BAND_COUNT; band++) {
+		ai_lod_band_counts[band] = 0;
+	}
 
-		// Enemy position
-		float enemy_posX = enemyMotion.position[0];
-		float enemy_posY = enemyMotion.position[1]; // we wouldn't need this for now, here for future use.
+	for (int i = 0; i < enemy_count; i++) {
+		Entity enemyEntity = enemy_registry.entities[i];
+		const EnemyInput& input = enemyInputs[i];
+		const EnemyDecision& decision = enemyDecisions[i];
 
+		enemy_registry.components[i] = decision.state;
+		ai_lod_band_counts[decision.state.ai_lod_band]++;
 
-		// DECISION TREE
+		if (decision.request_sight) {
+			lineOfSight.request(enemyEntity);
+		}
 
-		// 1. Figure out enemy type.
-		if (enemyComponent.enemyType == OBSTACLE) {
-			// 1_a.OBSTACLE enemies : **NOTE : these enemies will not die or freeze after a collision.
+		if (decision.flock) {
+			boids.add(input.bodyId, input.position, input.velocity, decision.pursuit, decision.steer, decision.force);
+			boidEntities.push_back(enemyEntity);
+		}
+		else if (decision.apply_force) {
+			b2Vec2 bodyPosition = b2Body_GetPosition(input.bodyId);
+			b2Body_ApplyForce(input.bodyId, b2Vec2{ decision.force.x, decision.force.y }, bodyPosition, true);
+		}
+	}
+	apply_us = std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - applyStart).count();
+
+	ai_los_queue_length = (int)lineOfSight.queue_length();
+
+	// 1ba_b. SWARMING enemies, all at once
+	if (boids.size() > 0) {
+		// same scale the old per-axis pushes used (pursuit force * 0.25 multiplier)
+		const float swarmPursuit_forceMagnitude = ENEMY_GROUNDED_MOVEMENT_FORCE * 0.08;
+		const float swarmForceScale = swarmPursuit_forceMagnitude * 0.25f;
+
+		auto swarmStart = std::chrono::high_resolution_clock::now();
+		boids_build_neighbours(boids);
+		boids_compute(boids, vec2(player_posX, player_posY), swarmForceScale);
+		boids_apply(boids);
+		for (size_t b = 0; b < boidEntities.size(); b++) {
+			registry.enemies.get(boidEntities[b]).ai_last_force = { boids.fx[b], boids.fy[b] };
+		}
+		swarm_step_us = std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - swarmStart).count();
+	}
+}
 
-			// Player gets an immunity window after hitting obstacle.
-			enemyComponent.freeze_time -= elapsed_ms;
+// One enemy's decision. Must stay a pure function of its arguments plus read-only state
+// (flow field, cached sight results, tick) so phase 1 gives the same answer on any thread count.
+void AISystem::decide(const EnemyInput& input, const Enemy& enemy, vec2 player_position, float elapsed_ms, EnemyDecision& out) const
+{
+	// Box2D physics
+	const float forceMagnitude = ENEMY_GROUNDED_MOVEMENT_FORCE;
 
-			// figure out lower and upper x-bound of patrol range (y doesn't matter as our movement vector ensures that if x triggers, y also triggers)
-			float left_hand_side = min(enemyComponent.movement_area_point_a.x, enemyComponent.movement_area_point_b.x);
-			float right_hand_side = max(enemyComponent.movement_area_point_a.x, enemyComponent.movement_area_point_b.x);
-			float bottom = min(enemyComponent.movement_area_point_a.y, enemyComponent.movement_area_point_b.y);
-			float top = max(enemyComponent.movement_area_point_a.y, enemyComponent.movement_area_point_b.y);
+	// Different enemy types have different weights, so we'll need to apply some corrections here to compensate.
+	const float obstacle_forceMagnitude = forceMagnitude * 200;
 
+	float multiplier = 0.25f; // raising/lowering this number affects the speed of the enemy. lower = more sluggish.
 
-			// compute the vector
-			vec2 point_a = enemyComponent.movement_area_point_a;
-			vec2 point_b = enemyComponent.movement_area_point_b;
-			// get deltas
-			float delta_x = point_b.x - point_a.x;
-			float delta_y = point_b.y - point_a.y;
+	vec2 nonjump_movement_force = { 0, 0 };
 
-			// normalize on x-axis
-			if (delta_x != 0 && delta_y != 0) {
-				delta_y = delta_y / delta_x;
-				delta_x = delta_x / delta_x; //could just set this to 1?
-			}
-			else if (delta_y == 0) {
-				delta_x = 1;
-			}
-			else if (delta_x == 0) {
-				delta_y = 1;
-			}
+	out.state = enemy;
+	out.force = { 0.f, 0.f };
+	out.apply_force = false;
+	out.flock = false;
+	out.steer = false;
+	out.pursuit = 0.f;
+	out.request_sight = false;
 
-			// normalize to always point right, or up if x = 0.
-			if (delta_x < 0) {
-				delta_x *= -1;
-				delta_y *= -1;
-			}
-			if (delta_x == 0 && delta_y < 0) {
-				delta_y *= -1;
-			}
+	Enemy& enemyComponent = out.state;
 
+	// Enemy position
+	float enemy_posX = input.position.x;
+	float player_posX = player_position.x;
 
-			// Decision tree here
-			// Only when we have a delta-x
-			if (delta_x != 0) {
-				if (enemyMotion.position.x <= left_hand_side + GRID_CELL_WIDTH_PX / 2) {
-					// 1aa_a. If too close to LHS, reverse directions.
+	// LEVEL OF DETAIL
+	enemyComponent.ai_lod_band = lodBand(enemy, length(input.position - player_position));
+	enemyComponent.ai_accumulated_ms += elapsed_ms;
 
-					// accelerate towards top-right
-					nonjump_movement_force = { delta_x * obstacle_forceMagnitude, delta_y * obstacle_forceMagnitude };
-				}
-				else if (enemyMotion.position.x >= right_hand_side - GRID_CELL_WIDTH_PX / 2) {
-					// 1aa_b. If too close to RHS, reverse directions.
+	if (enemyComponent.ai_lod_band == AI_LOD_FAR) {
+		// off-screen and far away: no steering, the body just coasts on its current velocity
+		enemyComponent.ai_last_force = { 0.f, 0.f };
+		return;
+	}
+	if (enemyComponent.ai_lod_band == AI_LOD_MID && (tick + enemy.ai_lod_phase) % AI_LOD_MID_INTERVAL != 0) {
+		// skipped tick: keep pushing with the last steering force so the motion doesn't stutter.
+		// A flocking swarm enemy still joins the flock as a neighbour of the boids updating this tick.
+		out.force = enemyComponent.ai_last_force;
+		out.apply_force = out.force != vec2(0.f, 0.f);
+		out.flock = enemyComponent.enemyType == SWARM && enemyComponent.freeze_time <= 0;
+		return;
+	}
 
-					// accelerate towards bottom-left
-					nonjump_movement_force = { -delta_x * obstacle_forceMagnitude, -delta_y * obstacle_forceMagnitude };
-				}
-			}
-			// If vertical movement then we switch logic to y-axis
-			else if (delta_x == 0) {
-				if (enemyMotion.position.y <= bottom + GRID_CELL_HEIGHT_PX / 2) {
-					// 1aa_d. If too close to bottom, reverse directions.
+	// time since this enemy last ran, so timers don't slow down for throttled enemies
+	float enemy_elapsed_ms = enemyComponent.ai_accumulated_ms;
+	enemyComponent.ai_accumulated_ms = 0.f;
 
-					// accelerate towards top-right
-					nonjump_movement_force = { delta_x * obstacle_forceMagnitude, delta_y * obstacle_forceMagnitude };
-				}
-				else if (enemyMotion.position.y >= top - GRID_CELL_HEIGHT_PX / 2) {
-					// 1aa_c. If too close to top, reverse directions.
 
-					// accelerate towards bottom-left
-					nonjump_movement_force = { -delta_x * obstacle_forceMagnitude, -delta_y * obstacle_forceMagnitude };
-				}
-			}
-			else {
-				// 1aa_c. Keep moving in current direction.
-				if (enemy_velocity.x == 0) {
-					// just move in default RHS/UP direction.
-					nonjump_movement_force = { delta_x * obstacle_forceMagnitude * 100, delta_y * obstacle_forceMagnitude * 100 };
-				}
-			}
+	// DECISION TREE
 
-		}
-		else {
-			// 1_b. NON-OBSTACLE enemies:
-			if (enemyComponent.freeze_time > 0) {
-				// 1b_a. If freeze-timer is above 0, decrement timer by elapsed time and exit.
-				enemyComponent.freeze_time -= elapsed_ms;
+	// 1. Figure out enemy type.
+	if (enemyComponent.enemyType == OBSTACLE) {
+		// 1_a.OBSTACLE enemies : **NOTE : these enemies will not die or freeze after a collision.
 
-			}
-			else {
-				if (enemyComponent.enemyType == COMMON) {
-					// 1ba_a.COMMON enemies :
-
-					if (player_posX < enemy_posX) {
-						// 1baa_a. If player is to the left, move left.
-
-						// accelerate left
-						nonjump_movement_force = { -forceMagnitude, 0 };
-					}
-					else if (enemy_posX < player_posX) {
-						// 2baa_b. If player is to the right, move right.
-
-						// accelerate right
-						nonjump_movement_force = { forceMagnitude, 0 };
-					}
-					
-				}
-				else if (enemyComponent.enemyType == SWARM) {
-					// 1ba_b. SWARMING enemies:
-					vec2 entityToAvoid = vec2(0, 0); // This will get modifed after calling helper function to be the position of the enemy to avoid
-					vec2 swarmRejoinLocation = vec2(-1000, -1000); // This will get modified after calling helper function to be the position of the swarm to rejoin
+		// Player gets an immunity window after hitting obstacle.
+		enemyComponent.freeze_time -= enemy_elapsed_ms;
 
-					// Reset whatever force they had
-					nonjump_movement_force = { 0, 0 };
+		// figure out lower and upper x-bound of patrol range (y doesn't matter as our movement vector ensures that if x triggers, y also triggers)
+		float left_hand_side = min(enemyComponent.movement_area_point_a.x, enemyComponent.movement_area_point_b.x);
+		float right_hand_side = max(enemyComponent.movement_area_point_a.x, enemyComponent.movement_area_point_b.x);
+		float bottom = min(enemyComponent.movement_area_point_a.y, enemyComponent.movement_area_point_b.y);
+		float top = max(enemyComponent.movement_area_point_a.y, enemyComponent.movement_area_point_b.y);
 
-					if (true) {
-						// 1bab_c. Pursue the player.
-
-						// Apply impulse on both X and Y axis to pursue player
-						if (player_posX < enemy_posX) {
-							// If player is to the left, move left.
-
-							// accelerate left
-							nonjump_movement_force += { -swarmPursuit_forceMagnitude, nonjump_movement_force.y };
-						}
-						else {
-							// If player is to the right, move right.
-
-							// accelerate right
-							nonjump_movement_force += { swarmPursuit_forceMagnitude, nonjump_movement_force.y };
-						}
-						if (player_posY <= enemy_posY) {
-							// If player is below, go down
-							nonjump_movement_force += { nonjump_movement_force.x, -swarmPursuit_forceMagnitude };
-						}
-						else {
-							// If player is above, go up
-							nonjump_movement_force += { nonjump_movement_force.x, swarmPursuit_forceMagnitude };
-						}
-					}
-
-					if (tooFarFromSwarm(enemyEntity, swarmRejoinLocation)) {
-					// 1bab_c. IF TOO FAR FROM SWARM, rejoin swarm.
-
-						// Apply impulse on both X and Y axis to pursue closest swarm enemy
-						if (swarmRejoinLocation.x < enemy_posX) {
-							// If closest swarm is to the left, move left.
-
-							// accelerate left
-							nonjump_movement_force += { -swarmCorrection_forceMagnitude, nonjump_movement_force.y };
-						}
-						else {
-							// If closest swarm is to the right, move right.
-
-							// accelerate right
-							nonjump_movement_force += { swarmCorrection_forceMagnitude, nonjump_movement_force.y };
-						}
-						if (swarmRejoinLocation.y <= enemy_posY) {
-							// If closest swarm is below, go down
-							nonjump_movement_force += { nonjump_movement_force.x, -swarmCorrection_forceMagnitude };
-						}
-						else {
-							// If closest swarm above, go up
-							nonjump_movement_force += { nonjump_movement_force.x, swarmCorrection_forceMagnitude };
-						}
-					}
-
-					else if (tooCloseToSwarm(enemyEntity, entityToAvoid)) {
-						// 1bab_b. IF TOO CLOSE TO ANOTHER SWARMING ENTITY THAT IS NOT THE PLAYER, move away from that entity.
-						
-						// We will apply both an x and y impulse so it goes in the opposite direction.
-						if (entityToAvoid.x <= enemyMotion.position.x) {
-							// Need to go right
-							nonjump_movement_force += { swarmCorrection_forceMagnitude, nonjump_movement_force.y }; 
-						}
-						else {
-							// Need to go left
-							nonjump_movement_force += { -swarmCorrection_forceMagnitude, nonjump_movement_force.y };
-						}
-						if (entityToAvoid.y <= enemyMotion.position.y) {
-							// Need to go up
-							nonjump_movement_force += { nonjump_movement_force.x, swarmCorrection_forceMagnitude };
-						}
-						else {
-							// Need to go down
-							nonjump_movement_force += { nonjump_movement_force.x, -swarmCorrection_forceMagnitude };
-						}
-					}
-				}
-			}
-		}
 
-		// Apply whatever decision made to box2D
-		// sanity check that enemy entity decided to move before applying
-		if (nonjump_movement_force != b2Vec2_zero || jump_impulse != b2Vec2_zero) {
-			PhysicsBody& phys = registry.physicsBodies.get(enemyEntity);
-			b2BodyId bodyId = phys.bodyId;
-			float multiplier = 0.25f; // raising/lowering this number affects the speed of the enemy. lower = more sluggish.
-			b2Vec2 bodyPosition = b2Body_GetPosition(bodyId);
-			b2Body_ApplyForce(bodyId, nonjump_movement_force * multiplier, bodyPosition, true);
+		// compute the vector
+		vec2 point_a = enemyComponent.movement_area_point_a;
+		vec2 point_b = enemyComponent.movement_area_point_b;
+		// get deltas
+		float delta_x = point_b.x - point_a.x;
+		float delta_y = point_b.y - point_a.y;
+
+		// normalize on x-axis
+		if (delta_x != 0 && delta_y != 0) {
+			delta_y = delta_y / delta_x;
+			delta_x = delta_x / delta_x; //could just set this to 1?
+		}
+		else if (delta_y == 0) {
+			delta_x = 1;
+		}
+		else if (delta_x == 0) {
+			delta_y = 1;
 		}
-		
-	}
 
-}
+		// normalize to always point right, or up if x = 0.
+		if (delta_x < 0) {
+			delta_x *= -1;
+			delta_y *= -1;
+		}
+		if (delta_x == 0 && delta_y < 0) {
+			delta_y *= -1;
+		}
 
-// Helper function that will determine if a swarm enemy is too close to another entity (that is not the player).
-bool AISystem::tooCloseToSwarm(Entity swarmEnemy, vec2& entityToAvoid)
-{
-	// Stuff that we'll need
-	Motion& enemyMotion = registry.motions.get(swarmEnemy);
-	Enemy& enemyComponent = registry.enemies.get(swarmEnemy);
 
+		// Decision tree here
+		// Only when we have a delta-x
+		if (delta_x != 0) {
+			if (input.position.x <= left_hand_side + GRID_CELL_WIDTH_PX / 2) {
+				// 1aa_a. If too close to LHS, reverse directions.
 
-	// Ground check
-	if (enemyMotion.position.y <= GRID_CELL_HEIGHT_PX / 4) {
-		entityToAvoid = vec2(enemyMotion.position.x, 0);
-		return true;
-	}
+				// accelerate towards top-right
+				nonjump_movement_force = { delta_x * obstacle_forceMagnitude, delta_y * obstacle_forceMagnitude };
+			}
+			else if (input.position.x >= right_hand_side - GRID_CELL_WIDTH_PX / 2) {
+				// 1aa_b. If too close to RHS, reverse directions.
 
-	// Now we just iterate over every physics body entity to see if it's too close
-	std::vector<Entity> physicsEntities = registry.physicsBodies.entities;
-	for (int i = 0; i < physicsEntities.size(); i++) {
-		Entity entity = physicsEntities[i];
+				// accelerate towards bottom-left
+				nonjump_movement_force = { -delta_x * obstacle_forceMagnitude, -delta_y * obstacle_forceMagnitude };
+			}
+		}
+		// If vertical movement then we switch logic to y-axis
+		else if (delta_x == 0) {
+			if (input.position.y <= bottom + GRID_CELL_HEIGHT_PX / 2) {
+				// 1aa_d. If too close to bottom, reverse directions.
 
-		// Ensure that we're not dealing with the player or the swarm enemy itself and the enemy has a motion component
-		if ((!registry.players.has(entity)) && (!(entity == swarmEnemy)) && registry.motions.has(entity)) {
-			Motion entityMotion = registry.motions.get(entity);
+				// accelerate towards top-right
+				nonjump_movement_force = { delta_x * obstacle_forceMagnitude, delta_y * obstacle_forceMagnitude };
+			}
+			else if (input.position.y >= top - GRID_CELL_HEIGHT_PX / 2) {
+				// 1aa_c. If too close to top, reverse directions.
 
-			if (abs(enemyMotion.position.x - entityMotion.position.x) <= GRID_CELL_WIDTH_PX/4 || abs(enemyMotion.position.y - entityMotion.position.y) <= GRID_CELL_HEIGHT_PX/4) {
-				entityToAvoid = entityMotion.position;
-				return true;
+				// accelerate towards bottom-left
+				nonjump_movement_force = { -delta_x * obstacle_forceMagnitude, -delta_y * obstacle_forceMagnitude };
+			}
+		}
+		else {
+			// 1aa_c. Keep moving in current direction.
+			if (input.velocity.x == 0) {
+				// just move in default RHS/UP direction.
+				nonjump_movement_force = { delta_x * obstacle_forceMagnitude * 100, delta_y * obstacle_forceMagnitude * 100 };
 			}
 		}
-	}
 
-	// If no enemies are too close then we can go ahead and return false
-	return false;
-}
+	}
+	else {
+		// 1_b. NON-OBSTACLE enemies:
+
+		// Awareness: refresh from the cached sight check (a new one is queued in phase 2 once it goes stale)
+		out.request_sight = true;
+		const LineOfSight::Result* sight = lineOfSight.cached(input.id);
+		if (sight != nullptr && sight->valid && sight->visible) {
+			enemyComponent.awareness_ms = ENEMY_AWARENESS_MEMORY_MS;
+		}
+		else {
+			enemyComponent.awareness_ms = max(0.f, enemyComponent.awareness_ms - enemy_elapsed_ms);
+		}
+		bool aware = enemyComponent.awareness_ms > 0.f;
 
-bool AISystem::tooFarFromSwarm(Entity swarmEnemy, vec2& closestSwarm) {
+		if (enemyComponent.freeze_time > 0) {
+			// 1b_a. If freeze-timer is above 0, decrement timer by elapsed time and exit.
+			enemyComponent.freeze_time -= enemy_elapsed_ms;
 
-	// Safety check: if there's only a single swarm enemy return false.
-	
+		}
+		else {
+			if (enemyComponent.enemyType == COMMON) {
+				// 1ba_a.COMMON enemies :
 
-	// Stuff that we'll need
-	Motion& selfMotion = registry.motions.get(swarmEnemy);
-	Enemy& selfComponent = registry.enemies.get(swarmEnemy);
+				vec2 flow_direction;
+				if (!aware) {
+					// hasn't seen the player: stay put
+					nonjump_movement_force = { 0, 0 };
+				}
+				else if (flowField.direction(input.position, flow_direction)) {
+					// route around terrain
+					nonjump_movement_force = { flow_direction.x * forceMagnitude, flow_direction.y * forceMagnitude };
+				}
+				else if (player_posX < enemy_posX) {
+					// 1baa_a. If player is to the left, move left.
 
-	// Now we just iterate over every enemy entity to see if we're too far from the swarm
-	std::vector<Entity> enemyEntities = registry.enemies.entities;
-	for (int i = 0; i < enemyEntities.size(); i++) {
-		Entity entity = enemyEntities[i];
-		Enemy enemyComponent = registry.enemies.get(entity);
+					// accelerate left
+					nonjump_movement_force = { -forceMagnitude, 0 };
+				}
+				else if (enemy_posX < player_posX) {
+					// 2baa_b. If player is to the right, move right.
 
-		// Ensure that we're dealing with a swarm enemy, but not the swarm enemy itself
-		if ((enemyComponent.enemyType == SWARM) && (!(entity == swarmEnemy))) {
-			Motion entityMotion = registry.motions.get(entity);
-			float currClosestDist = (selfMotion.position.x - closestSwarm.x) * (selfMotion.position.x - closestSwarm.x)
-				+ (selfMotion.position.y - closestSwarm.y) * (selfMotion.position.y - closestSwarm.y); //Pythagorean distance
-			float newClosestDist = (selfMotion.position.x - entityMotion.position.x) * (selfMotion.position.x - entityMotion.position.x)
-				+ (selfMotion.position.y - entityMotion.position.y) * (selfMotion.position.y - entityMotion.position.y);
+					// accelerate right
+					nonjump_movement_force = { forceMagnitude, 0 };
+				}
 
-			// If this swarm enemy is closer, we mark its location as the closest
-			if (newClosestDist < currClosestDist) {
-				closestSwarm = entityMotion.position;
 			}
-
+			else if (enemyComponent.enemyType == SWARM) {
+				// 1ba_b. SWARMING enemies: pursuit, separation and regrouping all come from the flocking pass.
+				out.flock = true;
+				out.steer = true;
+				out.pursuit = aware ? 1.f : 0.f;
+				return;
+			}
 		}
 	}
 
-	// if closest swarm enemy is still too far, then then we'll return true.
-	return (abs(closestSwarm.x - selfMotion.position.x) > SWARM_ENEMY_PROXIMITY || abs(closestSwarm.y - selfMotion.position.y) > SWARM_ENEMY_PROXIMITY);
+	// Whatever was decided gets applied to box2D in phase 2
+	// sanity check that enemy entity decided to move before applying
+	out.force = nonjump_movement_force * multiplier;
+	out.apply_force = nonjump_movement_force != vec2(0.f, 0.f);
+	// obstacle pushes are one-shot reversals and kicks, never held over skipped ticks
+	enemyComponent.ai_last_force = enemyComponent.enemyType == OBSTACLE ? vec2(0.f, 0.f) : out.force;
 }
 
 
+int AISystem::lodBand(const Enemy& enemy, float distance) const
+{
+	// moving outward needs the extra hysteresis margin, moving inward doesn't
+	float near_radius = AI_LOD_NEAR_RADIUS + (enemy.ai_lod_band >= AI_LOD_MID ? 0.f : AI_LOD_HYSTERESIS_PX);
+	float mid_radius = AI_LOD_MID_RADIUS + (enemy.ai_lod_band >= AI_LOD_FAR ? 0.f : AI_LOD_HYSTERESIS_PX);
+
+	if (distance <= near_radius) {
+		return AI_LOD_NEAR;
+	}
+	// obstacles patrol fixed routes; freezing them would leave them out of place when the player arrives
+	if (distance <= mid_radius || enemy.enemyType == OBSTACLE) {
+		return AI_LOD_MID;
+	}
+	return AI_LOD_FAR;
+}
+
@@ -3,15 +3,81 @@
 #include "common.hpp"
 #include "render_system.hpp"
 #include "tinyECS/registry.hpp"
+#include "boids.hpp"
+#include "flow_field.hpp"
+#include "line_of_sight.hpp"
+#include "worker_pool.hpp"
 #include "iostream"
 
+// What the decision phase needs to know about one enemy, gathered on the main thread.
+struct EnemyInput
+{
+	unsigned int id;
+	b2BodyId bodyId;
+	vec2 position;
+	vec2 velocity;
+};
+
+// What the decision phase wants done for one enemy. Applied on the main thread in entity order.
+struct EnemyDecision
+{
+	Enemy state;               // the enemy component after this tick
+	vec2 force;                // applied at the body position when apply_force is set
+	bool apply_force;
+	bool flock;                // swarm: steered by the flocking pass instead
+	bool steer;                // flocking: recompute its steer this tick (else it keeps force and is only a neighbour)
+	float pursuit;             // flocking pursuit weight
+	bool request_sight;        // queue a line-of-sight check if the cached one is stale
+};
+
+// Enemy AI runs in two phases: decide() for every enemy (read-only, split across worker
+// threads) into a per-enemy buffer, then one main-thread pass that writes the results
+// back and applies forces to Box2D in entity order. The outcome doesn't depend on the thread count.
 class AISystem
 {
 public:
+	explicit AISystem(b2WorldId worldId);
 	void step(float elapsed_ms);
 
+	// extra threads for the decision phase (0 = main thread only)
+	void setWorkerThreads(int extra_threads);
+	int workerThreads() const { return workers.thread_count() - 1; }
+
+	// cost of the last decision phase (gather + decide) and apply phase
+	float decide_us = 0.f;
+	float apply_us = 0.f;
+
+	// cost of the last flocking pass (neighbours + kernel + apply)
+	float swarm_step_us = 0.f;
+
+	// steps toward the player around terrain, used by COMMON enemies
+	FlowField flowField{ FLOW_FIELD_CELL_PX };
+
+	// budgeted, cached enemy -> player visibility checks
+	LineOfSight lineOfSight;
+
 private:
-	bool tooCloseToSwarm(Entity swarmEnemy, vec2& enemyToAvoid);
+	b2WorldId worldId;
+
+	void decide(const EnemyInput& input, const Enemy& enemy, vec2 player_position, float elapsed_ms, EnemyDecision& out) const;
+
+	// pick the LOD band for an enemy at the given distance from the player
+	int lodBand(const Enemy& enemy, float distance) const;
+
+	// level_terrain_version the flow field grid was built from
+	unsigned int flowFieldTerrainVersion = 0;
+
+	// AI ticks so far; MID enemies run when (tick + Enemy::ai_lod_phase) % AI_LOD_MID_INTERVAL == 0,
+	// the phase being fixed per enemy at spawn so the band's updates spread over the interval
+	unsigned int tick = 0;
+
+	// packed swarm state for the flocking kernel, reused every step
+	BoidsBuffer boids;
+	// entity for each boid, so the flocking forces can be cached on the Enemy
+	std::vector<Entity> boidEntities;
 
-	bool tooFarFromSwarm(Entity swarmEnemy, vec2& closestSwarmEntity);
+	// per-enemy buffers for the two phases, indexed like registry.enemies
+	std::vector<EnemyInput> enemyInputs;
+	std::vector<EnemyDecision> enemyDecisions;
+	WorkerPool workers{ AI_WORKER_THREADS };
 };
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <vector>
+
+// Per-frame measurements for one metric, summarised as mean / p50 / p99 / max.
+// Shared by the benchmark modes (bench/bench_sim.cpp, render_bench.cpp).
+struct Samples
+{
+	std::vector<double> values;
+
+	void add(double value) { values.push_back(value); }
+
+	Json::Value summary() const
+	{
+		Json::Value out;
+		if (values.empty()) {
+			return out;
+		}
+		std::vector<double> sorted = values;
+		std::sort(sorted.begin(), sorted.end());
+		double sum = 0.0;
+		for (double v : sorted) {
+			sum += v;
+		}
+		auto percentile = [&](double p) { return sorted[std::min(sorted.size() - 1, (size_t)(p * (sorted.size() - 1) + 0.5))]; };
+		out["mean"] = sum / sorted.size();
+		out["p50"] = percentile(0.50);
+		out["p99"] = percentile(0.99);
+		out["max"] = sorted.back();
+		return out;
+	}
+};
@@ -0,0 +1,210 @@
+#include "boids.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+void BoidsBuffer::clear()
+{
+	bodies.clear();
+	px.clear(); py.clear();
+	vx.clear(); vy.clear();
+	fx.clear(); fy.clear();
+	pursuit.clear();
+	steer.clear();
+	neighbour_start.clear();
+	neighbour_index.clear();
+}
+
+void BoidsBuffer::add(b2BodyId bodyId, vec2 position, vec2 velocity, float pursuit_weight, bool steer_this_tick, vec2 held_force)
+{
+	bodies.push_back(bodyId);
+	px.push_back(position.x);
+	py.push_back(position.y);
+	vx.push_back(velocity.x);
+	vy.push_back(velocity.y);
+	fx.push_back(held_force.x);
+	fy.push_back(held_force.y);
+	pursuit.push_back(pursuit_weight);
+	steer.push_back(steer_this_tick);
+}
+
+// Bins the boids into a dense grid over their bounding box (counting sort, cell = neighbour radius),
+// then each boid scans its 3x3 block. Much cheaper per query than going through the sparse
+// enemy grid, which matters with a thousand boids asking every tick.
+void boids_build_neighbours(BoidsBuffer &boids)
+{
+	const int n = (int)boids.size();
+	boids.neighbour_start.assign(n + 1, 0);
+	boids.neighbour_index.clear();
+	if (n == 0)
+		return;
+
+	const float cell = SWARM_NEIGHBOUR_RADIUS;
+	const float radius_sq = SWARM_NEIGHBOUR_RADIUS * SWARM_NEIGHBOUR_RADIUS;
+
+	float min_x = boids.px[0], min_y = boids.py[0], max_x = boids.px[0], max_y = boids.py[0];
+	for (int i = 1; i < n; i++)
+	{
+		min_x = std::min(min_x, boids.px[i]);
+		min_y = std::min(min_y, boids.py[i]);
+		max_x = std::max(max_x, boids.px[i]);
+		max_y = std::max(max_y, boids.py[i]);
+	}
+	const int cols = (int)((max_x - min_x) / cell) + 1;
+	const int rows = (int)((max_y - min_y) / cell) + 1;
+
+	// counting sort of boid indices by cell
+	std::vector<int> &cell_of = boids.scratch_cell;
+	cell_of.resize(n);
+	boids.cell_start.assign((size_t)cols * rows + 1, 0);
+	for (int i = 0; i < n; i++)
+	{
+		int cx = (int)((boids.px[i] - min_x) / cell);
+		int cy = (int)((boids.py[i] - min_y) / cell);
+		cell_of[i] = cy * cols + cx;
+		boids.cell_start[cell_of[i] + 1]++;
+	}
+	for (size_t c = 0; c + 1 < boids.cell_start.size(); c++)
+		boids.cell_start[c + 1] += boids.cell_start[c];
+
+	// positions are copied in cell order so each cell is a contiguous run
+	boids.sorted.resize(n);
+	boids.sorted_x.resize(n);
+	boids.sorted_y.resize(n);
+	std::vector<int> fill(boids.cell_start.begin(), boids.cell_start.end() - 1);
+	for (int i = 0; i < n; i++)
+	{
+		int slot = fill[cell_of[i]]++;
+		boids.sorted[slot] = i;
+		boids.sorted_x[slot] = boids.px[i];
+		boids.sorted_y[slot] = boids.py[i];
+	}
+
+	// gather neighbours, keeping the closest SWARM_MAX_NEIGHBOURS
+	// a boid can't have more candidates than there are boids
+	std::vector<std::pair<float, int>> &candidates = boids.scratch_candidates;
+	candidates.resize(n);
+	for (int i = 0; i < n; i++)
+	{
+		boids.neighbour_start[i] = (int)boids.neighbour_index.size();
+		int count = 0;
+
+		const float x_i = boids.px[i], y_i = boids.py[i];
+		const int cx = cell_of[i] % cols, cy = cell_of[i] / cols;
+		for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, rows - 1); y++)
+		{
+			// the three cells of a row are adjacent in the sorted arrays, so scan them as one run
+			const int first = boids.cell_start[y * cols + std::max(cx - 1, 0)];
+			const int last = boids.cell_start[y * cols + std::min(cx + 1, cols - 1) + 1];
+			const float *sx = boids.sorted_x.data();
+			const float *sy = boids.sorted_y.data();
+			// branch-free compaction: always write, only advance when inside the radius
+			for (int k = first; k < last; k++)
+			{
+				float dx = sx[k] - x_i;
+				float dy = sy[k] - y_i;
+				float d2 = dx * dx + dy * dy;
+				candidates[count] = {d2, boids.sorted[k]};
+				count += (d2 <= radius_sq && boids.sorted[k] != i);
+			}
+		}
+		if (count > SWARM_MAX_NEIGHBOURS)
+		{
+			std::nth_element(candidates.begin(), candidates.begin() + SWARM_MAX_NEIGHBOURS, candidates.begin() + count,
+							 [](const std::pair<float, int> &a, const std::pair<float, int> &b) { return a.first < b.first; });
+			count = SWARM_MAX_NEIGHBOURS;
+		}
+
+		for (int k = 0; k < count; k++)
+			boids.neighbour_index.push_back(candidates[k].second);
+	}
+	boids.neighbour_start[n] = (int)boids.neighbour_index.size();
+}
+
+void boids_compute(BoidsBuffer &boids, vec2 target, float force_scale)
+{
+	const int n = (int)boids.size();
+	const float *px = boids.px.data(), *py = boids.py.data();
+	const float *vx = boids.vx.data(), *vy = boids.vy.data();
+	float *fx = boids.fx.data(), *fy = boids.fy.data();
+	const float *pursuit = boids.pursuit.data();
+	const uint8_t *steer = boids.steer.data();
+	const int *start = boids.neighbour_start.data();
+	const int *index = boids.neighbour_index.data();
+
+	const float inv_sep_radius = 1.f / SWARM_SEPARATION_RADIUS;
+	const float inv_neighbour_radius = 1.f / SWARM_NEIGHBOUR_RADIUS;
+	const float inv_align_speed = 1.f / SWARM_ALIGNMENT_SPEED;
+	const float ground_height = GRID_CELL_HEIGHT_PX / 4.f;
+
+	for (int i = 0; i < n; i++)
+	{
+		if (!steer[i])
+			continue;
+
+		float sep_x = 0.f, sep_y = 0.f;
+		float sum_px = 0.f, sum_py = 0.f;
+		float sum_vx = 0.f, sum_vy = 0.f;
+
+		// branch-free accumulation over the gathered neighbours
+		const int count = start[i + 1] - start[i];
+		for (int k = start[i]; k < start[i + 1]; k++)
+		{
+			const int j = index[k];
+			float dx = px[i] - px[j];
+			float dy = py[i] - py[j];
+			float dist = std::sqrt(dx * dx + dy * dy) + 1e-3f;
+
+			// linear falloff inside the separation radius, zero outside
+			float push = std::max(0.f, 1.f - dist * inv_sep_radius) / dist;
+			sep_x += dx * push;
+			sep_y += dy * push;
+
+			sum_px += px[j];
+			sum_py += py[j];
+			sum_vx += vx[j];
+			sum_vy += vy[j];
+		}
+
+		float steer_x = 0.f, steer_y = 0.f;
+		if (count > 0)
+		{
+			const float inv_count = 1.f / count;
+
+			// cohesion: toward the local centre, full strength at the edge of the neighbourhood
+			float coh_x = (sum_px * inv_count - px[i]) * inv_neighbour_radius;
+			float coh_y = (sum_py * inv_count - py[i]) * inv_neighbour_radius;
+
+			// alignment: match the local average velocity
+			float ali_x = (sum_vx * inv_count - vx[i]) * inv_align_speed;
+			float ali_y = (sum_vy * inv_count - vy[i]) * inv_align_speed;
+
+			steer_x += SWARM_WEIGHT_SEPARATION * sep_x + SWARM_WEIGHT_COHESION * coh_x + SWARM_WEIGHT_ALIGNMENT * ali_x;
+			steer_y += SWARM_WEIGHT_SEPARATION * sep_y + SWARM_WEIGHT_COHESION * coh_y + SWARM_WEIGHT_ALIGNMENT * ali_y;
+		}
+
+		// pursuit: unit vector to the target
+		float tx = target.x - px[i];
+		float ty = target.y - py[i];
+		float tlen = std::sqrt(tx * tx + ty * ty) + 1e-3f;
+		steer_x += SWARM_WEIGHT_PURSUIT * pursuit[i] * tx / tlen;
+		steer_y += SWARM_WEIGHT_PURSUIT * pursuit[i] * ty / tlen;
+
+		// ground avoidance, ramps up as the boid gets close to the floor
+		steer_y += SWARM_WEIGHT_GROUND * std::max(0.f, 1.f - py[i] / ground_height);
+
+		// clamp the total steer, then scale to a force
+		float slen = std::sqrt(steer_x * steer_x + steer_y * steer_y);
+		float scale = force_scale * std::min(1.f, SWARM_MAX_STEER / std::max(slen, 1e-6f));
+		fx[i] = steer_x * scale;
+		fy[i] = steer_y * scale;
+	}
+}
+
+void boids_apply(const BoidsBuffer &boids)
+{
+	for (size_t i = 0; i < boids.size(); i++)
+	{
+		b2Body_ApplyForceToCenter(boids.bodies[i], b2Vec2{boids.fx[i], boids.fy[i]}, true);
+	}
+}
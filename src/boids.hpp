@@ -0,0 +1,42 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <box2d/box2d.h>
+
+// Flocking for SWARM enemies. State is packed into parallel arrays once per tick,
+// the kernel writes one steering force per boid into fx/fy, and apply() hands them to Box2D in one pass.
+struct BoidsBuffer
+{
+	std::vector<b2BodyId> bodies;
+	std::vector<float> px, py; // positions
+	std::vector<float> vx, vy; // velocities
+	std::vector<float> fx, fy; // output forces
+	std::vector<float> pursuit; // per-boid pursuit weight (0 = just flock)
+	std::vector<uint8_t> steer; // 0 = neighbour only this tick, fx/fy keep the force it was added with
+
+	// neighbour lists in CSR form: boid i's neighbours are neighbour_index[neighbour_start[i] .. neighbour_start[i+1])
+	std::vector<int> neighbour_start;
+	std::vector<int> neighbour_index;
+
+	// binning scratch, kept between ticks to avoid reallocating
+	std::vector<int> cell_start;
+	std::vector<int> sorted;
+	std::vector<float> sorted_x, sorted_y;
+	std::vector<int> scratch_cell;
+	std::vector<std::pair<float, int>> scratch_candidates;
+
+	void clear();
+	void add(b2BodyId bodyId, vec2 position, vec2 velocity, float pursuit_weight = 1.f, bool steer_this_tick = true, vec2 held_force = vec2(0.f));
+	size_t size() const { return px.size(); }
+};
+
+// fill the CSR neighbour lists (up to SWARM_MAX_NEIGHBOURS closest within SWARM_NEIGHBOUR_RADIUS)
+void boids_build_neighbours(BoidsBuffer &boids);
+
+// separation + alignment + cohesion + pursuit of target (times each boid's pursuit weight). The summed steer is clamped
+// to SWARM_MAX_STEER and multiplied by force_scale. Boids not steering this tick are only neighbours.
+void boids_compute(BoidsBuffer &boids, vec2 target, float force_scale);
+
+// push every force to Box2D
+void boids_apply(const BoidsBuffer &boids);
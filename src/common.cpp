@@ -6,6 +6,77 @@ int WORLD_HEIGHT_TILES = 1;
 
 int WORLD_WIDTH_PX = 1;
 int WORLD_HEIGHT_PX = 1;
+
+bool SWARM_SWARM_CONTACTS = false;
+bool GRAPPLE_ROPE_MODE = false;
+bool grapplePointActive = false;
+bool grappleActive = false;
+int ai_lod_band_counts[AI_LOD_BAND_COUNT] = { 0, 0, 0 };
+int ai_los_rays_last_step = 0;
+int ai_los_queue_length = 0;
+
+b2Filter collision_filter(COLLISION_CATEGORY category)
+{
+	b2Filter filter = b2DefaultFilter();
+	filter.categoryBits = category;
+
+	switch (category)
+	{
+	case CATEGORY_PLAYER:
+		filter.maskBits = CATEGORY_TERRAIN | CATEGORY_ENEMIES;
+		break;
+	case CATEGORY_COMMON:
+	case CATEGORY_OBSTACLE:
+		filter.maskBits = CATEGORY_PLAYER | CATEGORY_TERRAIN | CATEGORY_ENEMIES;
+		break;
+	case CATEGORY_SWARM:
+		filter.maskBits = CATEGORY_PLAYER | CATEGORY_TERRAIN | CATEGORY_COMMON | CATEGORY_OBSTACLE;
+		if (SWARM_SWARM_CONTACTS) filter.maskBits |= CATEGORY_SWARM;
+		break;
+	case CATEGORY_TERRAIN:
+		filter.maskBits = CATEGORY_PLAYER | CATEGORY_ENEMIES;
+		break;
+	// sensors, grapple anchors and UI never generate contacts
+	case CATEGORY_SENSOR:
+	case CATEGORY_GRAPPLE_ANCHOR:
+	case CATEGORY_UI:
+	default:
+		filter.maskBits = 0;
+		break;
+	}
+
+	return filter;
+}
+
+COLLISION_CATEGORY enemy_collision_category(ENEMY_TYPES enemy_type)
+{
+	switch (enemy_type)
+	{
+	case SWARM:
+		return CATEGORY_SWARM;
+	case OBSTACLE:
+		return CATEGORY_OBSTACLE;
+	case COMMON:
+	default:
+		return CATEGORY_COMMON;
+	}
+}
+
+b2QueryFilter grapple_query_filter()
+{
+	b2QueryFilter filter = b2DefaultQueryFilter();
+	filter.categoryBits = CATEGORY_PLAYER;
+	filter.maskBits = CATEGORY_TERRAIN;
+	return filter;
+}
+
+b2QueryFilter line_of_sight_query_filter()
+{
+	b2QueryFilter filter = b2DefaultQueryFilter();
+	filter.categoryBits = CATEGORY_COMMON;
+	filter.maskBits = CATEGORY_TERRAIN;
+	return filter;
+}
 	
 // note, we could also use the functions from GLM but we write the transformations here to show the underlying math
 void Transform::scale(vec2 scale)
@@ -27,39 +98,3 @@ void Transform::translate(vec2 offset)
 	mat3 T = { { 1.f, 0.f, 0.f },{ 0.f, 1.f, 0.f },{ offset.x, offset.y, 1.f } };
 	mat = mat * T;
 }
-
-bool gl_has_errors()
-{
-	GLenum error = glGetError();
-
-	if (error == GL_NO_ERROR) return false;
-
-	while (error != GL_NO_ERROR)
-	{
-		const char* error_str = "";
-		switch (error)
-		{
-		case GL_INVALID_OPERATION:
-			error_str = "INVALID_OPERATION";
-			break;
-		case GL_INVALID_ENUM:
-			error_str = "INVALID_ENUM";
-			break;
-		case GL_INVALID_VALUE:
-			error_str = "INVALID_VALUE";
-			break;
-		case GL_OUT_OF_MEMORY:
-			error_str = "OUT_OF_MEMORY";
-			break;
-		case GL_INVALID_FRAMEBUFFER_OPERATION:
-			error_str = "INVALID_FRAMEBUFFER_OPERATION";
-			break;
-		}
-
-		fprintf(stderr, "OpenGL: %s", error_str);
-		error = glGetError();
-		assert(false);
-	}
-
-	return true;
-}
\ No newline at end of file
@@ -173,12 +173,63 @@ const float KILLSTREAK_RESET_TIME = 60.f;
 // SWARM ENEMY PROXIMITY - MAX DELTA X OR DELTA Y FROM SWARM BEFORE REJOINING
 const float SWARM_ENEMY_PROXIMITY = 1.5 * GRID_CELL_WIDTH_PX;
 
+// AI LEVEL OF DETAIL
+// Enemies are banded by distance to the player. NEAR runs the AI every tick, MID every
+// AI_LOD_MID_INTERVAL ticks (reapplying its last steering force in between), FAR stops steering and
+// just coasts under physics. Obstacles never go FAR so their patrols stay in range.
+enum AI_LOD_BAND { AI_LOD_NEAR = 0, AI_LOD_MID = 1, AI_LOD_FAR = 2, AI_LOD_BAND_COUNT = 3 };
+const float AI_LOD_NEAR_RADIUS = 1.0f * WINDOW_WIDTH_PX;
+const float AI_LOD_MID_RADIUS = 3.0f * WINDOW_WIDTH_PX;
+const int AI_LOD_MID_INTERVAL = 4;
+// an enemy must be this far past a radius before dropping to the farther band, so it doesn't flicker on the boundary
+const float AI_LOD_HYSTERESIS_PX = 0.1f * WINDOW_WIDTH_PX;
+// enemies per band during the last AI step (shown in the window title in debug mode)
+extern int ai_lod_band_counts[AI_LOD_BAND_COUNT];
+
+// AI THREADING. The decision phase is split across AI_WORKER_THREADS extra threads once
+// there are at least AI_PARALLEL_MIN_ENEMIES enemies (below that the hand-off costs more than it saves).
+const int AI_WORKER_THREADS = 3;
+const int AI_PARALLEL_MIN_ENEMIES = 128;
+
+// LINE OF SIGHT. Enemies queue visibility checks against the player; at most LOS_RAY_BUDGET
+// rays are cast per tick, and an answer is reused until it is LOS_RESULT_TTL_MS old.
+const int LOS_RAY_BUDGET = 32;
+const float LOS_RESULT_TTL_MS = 250.0f;
+const float ENEMY_AWARENESS_MEMORY_MS = 3000.0f; // how long an enemy keeps chasing after losing sight
+// rays cast and requests still waiting after the last AI step (shown in the window title in debug mode)
+extern int ai_los_rays_last_step;
+extern int ai_los_queue_length;
+
+// FLOW FIELD (COMMON enemy pathing). Cells are half a grid cell so an enemy standing on a floor
+// is usually in an open cell above it. The search toward the player is spread over frames,
+// a fixed number of cells per tick (not a time budget, so replays and the bench stay deterministic).
+const float FLOW_FIELD_CELL_PX = GRID_CELL_WIDTH_PX * 0.5f;
+const int FLOW_FIELD_CELLS_PER_TICK = 8192; // roughly 200 us
+const int FLOW_FIELD_SUPPORT_CELLS = 2; // an open cell counts as floor if terrain is this close below
+
+// SWARM FLOCKING (boids). Each term is roughly unit length before weighting;
+// the sum is clamped to SWARM_MAX_STEER and scaled to the old swarm pursuit force.
+const float SWARM_NEIGHBOUR_RADIUS = SWARM_ENEMY_PROXIMITY;    // alignment + cohesion range
+const float SWARM_SEPARATION_RADIUS = 2.5f * ENEMY_RADIUS;     // personal space
+const int SWARM_MAX_NEIGHBOURS = 16;                           // closest neighbours considered per boid
+const float SWARM_ALIGNMENT_SPEED = 200.0f;                    // velocity difference that counts as a full alignment push (px/s)
+const float SWARM_WEIGHT_PURSUIT = 1.0f;
+const float SWARM_WEIGHT_SEPARATION = 1.5f;
+const float SWARM_WEIGHT_ALIGNMENT = 0.3f;
+const float SWARM_WEIGHT_COHESION = 0.4f;
+const float SWARM_WEIGHT_GROUND = 1.5f;                        // pull up when skimming the floor
+const float SWARM_MAX_STEER = 1.5f;
+
 // TERRAIN PHYSICS
 const float TERRAIN_DEFAULT_FRICTION = 0.2f;
 const float TERRAIN_DEFAULT_RESTITUTION = 0.0f;
 const float CURVED_RAMP_FRICTION = 0.01f;
 const float CURVED_RAMP_RESTITUTION = 0.01f;
 const float WALL_DEFAULT_THICKNESS = 4.0f;
+// Terrain chains are simplified on load: vertices closer than this are welded together...
+const float TERRAIN_WELD_TOLERANCE = 0.5f;
+// ...and a vertex within this distance of the simplified segment replacing it is merged away.
+const float TERRAIN_COLLINEAR_TOLERANCE = 0.25f;
 
 // GRAPPLE PHYSICS
 const float GRAPPLE_DETRACT_GROUNDED = 20.0f;
@@ -187,10 +238,50 @@ const float GRAPPLE_HERTZ_GROUNDED = 1.0f;
 const float GRAPPLE_DAMPING_GROUNDED = 0.5f;
 const float GRAPPLE_MAX_LENGTH = 450.0f;
 const float GRAPPLE_MIN_LENGTH = 100.0f;
+// anchor bodies/joints created up front per level; the pool grows past this if needed
+const int GRAPPLE_POOL_SIZE = 4;
+
+// GRAPPLE TRAJECTORY PREVIEW
+const float GRAPPLE_PREVIEW_DURATION = 1.5f;        // seconds of flight to predict
+const float GRAPPLE_PREVIEW_STEP = 1.0f / 240.0f;   // shadow world step
+const int GRAPPLE_PREVIEW_SAMPLE_EVERY = 8;         // steps between arc points
+const float GRAPPLE_PREVIEW_BUDGET_US = 500.0f;     // arc is cut short past this
+const float GRAPPLE_PREVIEW_POSITION_EPSILON = 2.0f;  // cache is reused while the aim/ball move less than this (px)
+const float GRAPPLE_PREVIEW_VELOCITY_EPSILON = 10.0f; // ...and the ball speed changes less than this (px/s)
+
+// GRAPPLE ROPE (segmented Verlet rope, toggled with G)
+extern bool GRAPPLE_ROPE_MODE;
+
+// grapple state, shared by the world and physics systems
+extern bool grapplePointActive; // Bool to check if grapple is on a grapple point
+extern bool grappleActive;		// Bool to check if grapple is active
+const int GRAPPLE_ROPE_SEGMENTS = 64;
+const int GRAPPLE_ROPE_ITERATIONS = 8;       // constraint passes per frame
+const float GRAPPLE_ROPE_DAMPING = 0.98f;
+const float GRAPPLE_ROPE_RADIUS = 3.0f;      // how far particles are kept off terrain
+const float GRAPPLE_ROPE_BUDGET_US = 150.0f; // per-frame cost target for rope_step()
 
 // change this to change the clickable area to attach to a grapple point
 const float GRAPPLE_ATTACH_ZONE_RADIUS = 128.0f; // 256.0f;
 
+// COLLISION FILTERS
+// Every shape gets one category; the mask table in collision_filter() decides what it touches.
+enum COLLISION_CATEGORY : uint32_t {
+    CATEGORY_PLAYER = 0x0001,
+    CATEGORY_COMMON = 0x0002,
+    CATEGORY_SWARM = 0x0004,
+    CATEGORY_OBSTACLE = 0x0008,
+    CATEGORY_TERRAIN = 0x0010,
+    CATEGORY_SENSOR = 0x0020,
+    CATEGORY_GRAPPLE_ANCHOR = 0x0040,
+    CATEGORY_UI = 0x0080
+};
+const uint32_t CATEGORY_ENEMIES = CATEGORY_COMMON | CATEGORY_SWARM | CATEGORY_OBSTACLE;
+
+// Swarm enemies flock together and only need their boids steering to keep apart.
+// Turning this on lets them generate contacts with each other again (much higher pair count).
+extern bool SWARM_SWARM_CONTACTS;
+
 // These are hard coded to the dimensions of the entity's texture
 // invaders are 64x64 px, but cells are 60x60
 const float INVADER_BB_WIDTH = (float)GRID_CELL_WIDTH_PX;
@@ -252,7 +343,22 @@ inline glm::vec2 rotateAroundPoint(const vec2 &point, const vec2 &origin, float
     return result;
 }
 
+// GL error checking is debug-only: release builds compile every call away. In debug builds
+// with KHR_debug the driver reports errors through a callback instead (see RenderSystem::init).
+#ifdef NDEBUG
+inline bool gl_has_errors() { return false; }
+#else
 bool gl_has_errors();
+#endif
+
+// filter for a shape of the given category, built from the category/mask table
+b2Filter collision_filter(COLLISION_CATEGORY category);
+// category used by the enemy factory for each enemy type
+COLLISION_CATEGORY enemy_collision_category(ENEMY_TYPES enemy_type);
+// ray query filter for grapple shots: only terrain can be grappled
+b2QueryFilter grapple_query_filter();
+// ray query filter for enemy line of sight: only terrain blocks the view
+b2QueryFilter line_of_sight_query_filter();
 
 // used for delimiting point names
 inline std::vector<std::string> split(std::string s, std::string delimiter)
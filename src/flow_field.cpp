@@ -0,0 +1,291 @@
+#include "flow_field.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <iostream>
+
+FlowField::FlowField(float cell_size)
+	: cell_size(cell_size)
+{
+	assert(cell_size > 0.f);
+}
+
+void FlowField::build_grid(float world_width, float world_height, const std::vector<TerrainChain> &chains)
+{
+	grid_width = std::max(1, (int)ceil(world_width / cell_size));
+	grid_height = std::max(1, (int)ceil(world_height / cell_size));
+	blocked.assign(grid_width * grid_height, 0);
+
+	for (const TerrainChain &chain : chains) {
+		size_t n = chain.points.size();
+		if (n < 2) {
+			continue;
+		}
+		for (size_t i = 0; i + 1 < n; i++) {
+			mark_segment(chain.points[i], chain.points[i + 1]);
+		}
+		if (chain.isLoop) {
+			mark_segment(chain.points[n - 1], chain.points[0]);
+		}
+	}
+
+	supported.assign(grid_width * grid_height, 0);
+	for (int y = 0; y < grid_height; y++) {
+		for (int x = 0; x < grid_width; x++) {
+			if (!open(x, y)) {
+				continue;
+			}
+			for (int below = 1; below <= FLOW_FIELD_SUPPORT_CELLS && y - below >= 0; below++) {
+				if (blocked[(y - below) * grid_width + x]) {
+					supported[y * grid_width + x] = 1;
+					break;
+				}
+			}
+		}
+	}
+
+	distance.assign(grid_width * grid_height, -1);
+	pending.assign(grid_width * grid_height, -1);
+	queue.clear();
+	queue.reserve(grid_width * grid_height);
+	queue_head = 0;
+	live_target_cell = -1;
+	pending_target_cell = -1;
+	searching = false;
+	ticks = 0;
+	live_start_tick = 0;
+	pending_start_tick = 0;
+	field_age_ticks = 0;
+
+	int blocked_count = 0;
+	int supported_count = 0;
+	for (size_t i = 0; i < blocked.size(); i++) {
+		blocked_count += blocked[i];
+		supported_count += supported[i];
+	}
+	std::cout << "Flow field: " << grid_width << "x" << grid_height << " cells, " << blocked_count << " blocked, "
+		<< supported_count << " walkable." << std::endl;
+}
+
+// Walk the segment in quarter-cell steps and block every cell it touches.
+void FlowField::mark_segment(vec2 a, vec2 b)
+{
+	float len = length(b - a);
+	int steps = std::max(1, (int)ceil(len / (cell_size * 0.25f)));
+	for (int s = 0; s <= steps; s++) {
+		vec2 p = a + (b - a) * ((float)s / (float)steps);
+		int cell = cell_of(p);
+		if (cell >= 0) {
+			blocked[cell] = 1;
+		}
+	}
+}
+
+int FlowField::cell_of(vec2 position) const
+{
+	int x = (int)floor(position.x / cell_size);
+	int y = (int)floor(position.y / cell_size);
+	if (x < 0 || y < 0 || x >= grid_width || y >= grid_height) {
+		return -1;
+	}
+	return y * grid_width + x;
+}
+
+// The player's centre often sits in a cell the floor runs through; seed from the closest open cell around it instead.
+int FlowField::open_cell_near(vec2 position) const
+{
+	int cell = cell_of(position);
+	if (cell < 0 || !blocked[cell]) {
+		return cell;
+	}
+	int cx = cell % grid_width;
+	int cy = cell / grid_width;
+	int best = -1;
+	float best_distance = 0.f;
+	for (int ny = cy - 1; ny <= cy + 1; ny++) {
+		for (int nx = cx - 1; nx <= cx + 1; nx++) {
+			if (!open(nx, ny)) {
+				continue;
+			}
+			int neighbour = ny * grid_width + nx;
+			float d = length(cell_center(neighbour) - position);
+			if (best < 0 || d < best_distance) {
+				best = neighbour;
+				best_distance = d;
+			}
+		}
+	}
+	return best;
+}
+
+vec2 FlowField::cell_center(int cell) const
+{
+	return vec2(((cell % grid_width) + 0.5f) * cell_size, ((cell / grid_width) + 0.5f) * cell_size);
+}
+
+bool FlowField::open(int x, int y) const
+{
+	return x >= 0 && y >= 0 && x < grid_width && y < grid_height && !blocked[y * grid_width + x];
+}
+
+bool FlowField::walkable(int x, int y) const
+{
+	return open(x, y) && supported[y * grid_width + x];
+}
+
+// An airborne target is searched from the floor under it, the closest enemies can get.
+// Stays put if there is no floor straight below.
+int FlowField::ground_cell_below(int cell) const
+{
+	if (cell < 0) {
+		return cell;
+	}
+	int x = cell % grid_width;
+	for (int y = cell / grid_width; open(x, y); y--) {
+		if (supported[y * grid_width + x]) {
+			return y * grid_width + x;
+		}
+	}
+	return cell;
+}
+
+void FlowField::update(vec2 target, int cell_budget)
+{
+	cells_expanded = 0;
+	if (blocked.empty()) {
+		return;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	int target_cell = ground_cell_below(open_cell_near(target));
+	if (!searching && target_cell >= 0 && target_cell != live_target_cell) {
+		// target moved to another cell: start a new search (the live field keeps serving lookups).
+		// A running search is never restarted, only finished, so on grids that take several ticks
+		// to search a fast target waits for the rest of that search plus its own, never longer.
+		std::fill(pending.begin(), pending.end(), -1);
+		queue.clear();
+		queue_head = 0;
+		queue.push_back(target_cell);
+		pending[target_cell] = 0;
+		pending_target_cell = target_cell;
+		pending_start_tick = ticks;
+		searching = true;
+	}
+	if (searching && target_cell == pending_target_cell) {
+		pending_target = target;
+	}
+	if (target_cell == live_target_cell) {
+		live_target = target;
+	}
+
+	const int dx[4] = { 1, -1, 0, 0 };
+	const int dy[4] = { 0, 0, 1, -1 };
+
+	if (searching) {
+		while (cells_expanded < cell_budget && queue_head < queue.size()) {
+			int cell = queue[queue_head++];
+			int cx = cell % grid_width;
+			int cy = cell / grid_width;
+			int next_distance = pending[cell] + 1;
+			bool cell_walkable = walkable(cx, cy);
+			for (int d = 0; d < 4; d++) {
+				int nx = cx + dx[d];
+				int ny = cy + dy[d];
+				// the search runs backwards: can an enemy in the neighbour move into this cell?
+				// Falling in from straight above always works, walking needs floor under the
+				// neighbour (off a ledge is fine) and climbing needs floor on both ends.
+				bool can_move = false;
+				if (dy[d] == 1) {
+					can_move = open(nx, ny);
+				}
+				else if (dy[d] == 0) {
+					can_move = walkable(nx, ny);
+				}
+				else {
+					can_move = cell_walkable && walkable(nx, ny);
+				}
+				if (!can_move) {
+					continue;
+				}
+				int neighbour = ny * grid_width + nx;
+				if (pending[neighbour] < 0) {
+					pending[neighbour] = next_distance;
+					queue.push_back(neighbour);
+				}
+			}
+			cells_expanded++;
+		}
+
+		if (queue_head >= queue.size()) {
+			// finished: publish it
+			distance.swap(pending);
+			live_target_cell = pending_target_cell;
+			live_target = pending_target;
+			live_start_tick = pending_start_tick;
+			searching = false;
+			searches_completed++;
+		}
+	}
+	field_age_ticks = target_cell == live_target_cell ? 0 : ticks - live_start_tick;
+	ticks++;
+
+	update_us = std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+bool FlowField::direction(vec2 position, vec2 &out_direction) const
+{
+	if (live_target_cell < 0) {
+		return false;
+	}
+	int cell = cell_of(position);
+	if (cell < 0) {
+		return false;
+	}
+
+	if (cell == live_target_cell) {
+		vec2 to_target = live_target - position;
+		if (length(to_target) < 1e-3f) {
+			return false;
+		}
+		out_direction = normalize(to_target);
+		return true;
+	}
+
+	// Step toward the neighbour closest to the target. Diagonals only if both sides are open,
+	// so the enemy doesn't try to cut a corner through terrain. If we're standing in a blocked
+	// (or unreached) cell, this still finds the best open cell next to us.
+	int cx = cell % grid_width;
+	int cy = cell / grid_width;
+	int best = -1;
+	int best_distance = distance[cell] >= 0 ? distance[cell] : INT_MAX;
+	for (int ny = cy - 1; ny <= cy + 1; ny++) {
+		for (int nx = cx - 1; nx <= cx + 1; nx++) {
+			if ((nx == cx && ny == cy) || !open(nx, ny)) {
+				continue;
+			}
+			if (nx != cx && ny != cy && (!open(nx, cy) || !open(cx, ny))) {
+				continue;
+			}
+			int neighbour = ny * grid_width + nx;
+			int d = distance[neighbour];
+			if (d >= 0 && d < best_distance) {
+				best_distance = d;
+				best = neighbour;
+			}
+		}
+	}
+	if (best < 0) {
+		return false;
+	}
+
+	vec2 to_next = cell_center(best) - position;
+	if (length(to_next) < 1e-3f) {
+		return false;
+	}
+	out_direction = normalize(to_next);
+	return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "common.hpp"
+#include "terrain.hpp"
+
+#include <vector>
+
+// Grid over the level where every cell knows its step distance to the target (the player).
+// Cells crossed by terrain are blocked. An open cell with terrain just below it is walkable:
+// enemies walk from walkable cells (off ledges too), fall straight down through open ones and
+// can't jump, so they only climb where there is floor all the way. The search runs breadth-first over those moves
+// from the target's cell, dropped to the ground under it while the target is airborne.
+// The search runs in slices of a fixed cell count and the last finished field stays readable
+// until the new one completes, so lookups are always O(1). A running search always finishes
+// before the next one starts, so the live field lags the target by at most two searches.
+class FlowField
+{
+public:
+	explicit FlowField(float cell_size);
+
+	// Rasterise the chains into the blocked mask. Drops any existing field.
+	void build_grid(float world_width, float world_height, const std::vector<TerrainChain> &chains);
+
+	// Call once per tick. Starts a search when the target is in another cell than the live
+	// field's and none is running, then expands at most cell_budget cells of the pending search.
+	void update(vec2 target, int cell_budget);
+
+	// Longest a search can take at cell_budget per tick
+	int max_search_ticks(int cell_budget) const { return (grid_width * grid_height + cell_budget - 1) / cell_budget; }
+
+	// Unit direction to move from position toward the target. False if no route is known.
+	bool direction(vec2 position, vec2 &out_direction) const;
+
+	bool has_field() const { return live_target_cell >= 0; }
+	int width() const { return grid_width; }
+	int height() const { return grid_height; }
+
+	// stats for the last update()
+	int cells_expanded = 0;
+	float update_us = 0.f;
+	int searches_completed = 0;
+	// ticks since the search behind the live field started, 0 while the target is still in
+	// its cell; at most the rest of one search plus the next, 2 * max_search_ticks() + 1
+	int field_age_ticks = 0;
+
+private:
+	int cell_of(vec2 position) const;
+	int open_cell_near(vec2 position) const;
+	vec2 cell_center(int cell) const;
+	bool open(int x, int y) const;
+	bool walkable(int x, int y) const;
+	int ground_cell_below(int cell) const;
+	void mark_segment(vec2 a, vec2 b);
+
+	float cell_size;
+	int grid_width = 0;
+	int grid_height = 0;
+	std::vector<uint8_t> blocked;
+	std::vector<uint8_t> supported; // open with terrain within FLOW_FIELD_SUPPORT_CELLS below
+
+	// live field: what direction() reads
+	std::vector<int> distance;
+	int live_target_cell = -1;
+	vec2 live_target = { 0.f, 0.f };
+
+	// field being built
+	std::vector<int> pending;
+	std::vector<int> queue;
+	size_t queue_head = 0;
+	int pending_target_cell = -1;
+	vec2 pending_target = { 0.f, 0.f };
+	bool searching = false;
+
+	// update() calls so far, and the one each field's search started on
+	int ticks = 0;
+	int live_start_tick = 0;
+	int pending_start_tick = 0;
+};
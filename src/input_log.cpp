@@ -0,0 +1,218 @@
+#include "input_log.hpp"
+#include "tinyECS/registry.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const char INPUT_LOG_MAGIC[4] = { 'R', 'M', 'R', 'P' };
+static const uint32_t INPUT_LOG_VERSION = 1;
+
+template <typename T>
+static void write_value(std::ofstream &out, const T &value)
+{
+	out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool read_value(const std::vector<char> &data, size_t &offset, T &value)
+{
+	if (offset + sizeof(T) > data.size()) {
+		return false;
+	}
+	memcpy(&value, data.data() + offset, sizeof(T));
+	offset += sizeof(T);
+	return true;
+}
+
+InputLog::~InputLog()
+{
+	stop();
+}
+
+bool InputLog::start_recording(const std::string &path, const Header &header)
+{
+	stop();
+	out.open(path, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		std::cerr << "ERROR: could not open " << path << " for recording" << std::endl;
+		return false;
+	}
+	out.write(INPUT_LOG_MAGIC, sizeof(INPUT_LOG_MAGIC));
+	write_value(out, INPUT_LOG_VERSION);
+	write_value(out, (int32_t)header.level);
+	write_value(out, header.flags);
+	write_value(out, header.seed);
+
+	current_header = header;
+	current_mode = MODE::RECORDING;
+	pending_clicks.clear();
+	ticks = 0;
+	return true;
+}
+
+bool InputLog::start_replay(const std::string &path)
+{
+	stop();
+	std::ifstream in(path, std::ios::binary);
+	if (!in.is_open()) {
+		std::cerr << "ERROR: could not open replay " << path << std::endl;
+		return false;
+	}
+	data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	read_offset = 0;
+
+	char magic[sizeof(INPUT_LOG_MAGIC)];
+	uint32_t version = 0;
+	int32_t level = 0;
+	Header header;
+	bool ok = read_value(data, read_offset, magic) && memcmp(magic, INPUT_LOG_MAGIC, sizeof(magic)) == 0 &&
+			  read_value(data, read_offset, version) && version == INPUT_LOG_VERSION &&
+			  read_value(data, read_offset, level) &&
+			  read_value(data, read_offset, header.flags) &&
+			  read_value(data, read_offset, header.seed);
+	if (!ok) {
+		std::cerr << "ERROR: " << path << " is not a version " << INPUT_LOG_VERSION << " input recording" << std::endl;
+		data.clear();
+		return false;
+	}
+	header.level = level;
+
+	current_header = header;
+	current_mode = MODE::REPLAYING;
+	ticks = 0;
+	desyncs = 0;
+	first_desync = -1;
+	return true;
+}
+
+void InputLog::stop()
+{
+	if (current_mode == MODE::RECORDING) {
+		out.close();
+		std::cout << "Recorded " << ticks << " ticks" << std::endl;
+	}
+	else if (current_mode == MODE::REPLAYING) {
+		std::cout << "Replayed " << ticks << " ticks, " << desyncs << " desynced";
+		if (first_desync >= 0) {
+			std::cout << " (first at tick " << first_desync << ")";
+		}
+		std::cout << std::endl;
+		data.clear();
+	}
+	current_mode = MODE::OFF;
+}
+
+void InputLog::record_click(vec2 world_position)
+{
+	if (current_mode == MODE::RECORDING) {
+		pending_clicks.push_back(world_position);
+	}
+}
+
+void InputLog::record_tick(float elapsed_ms, uint64_t checksum, uint16_t keys)
+{
+	if (current_mode != MODE::RECORDING) {
+		return;
+	}
+	// a u8 count is plenty: these are clicks within one frame
+	uint8_t clickCount = (uint8_t)std::min<size_t>(pending_clicks.size(), 255);
+
+	write_value(out, elapsed_ms);
+	write_value(out, checksum);
+	write_value(out, keys);
+	write_value(out, clickCount);
+	for (uint8_t i = 0; i < clickCount; i++) {
+		write_value(out, pending_clicks[i].x);
+		write_value(out, pending_clicks[i].y);
+	}
+	pending_clicks.clear();
+	ticks++;
+}
+
+bool InputLog::next_tick(Tick &tick)
+{
+	if (current_mode != MODE::REPLAYING) {
+		return false;
+	}
+	uint8_t clickCount = 0;
+	if (!read_value(data, read_offset, tick.elapsed_ms) ||
+		!read_value(data, read_offset, tick.checksum) ||
+		!read_value(data, read_offset, tick.keys) ||
+		!read_value(data, read_offset, clickCount)) {
+		return false;
+	}
+	tick.clicks.resize(clickCount);
+	for (vec2 &click : tick.clicks) {
+		if (!read_value(data, read_offset, click.x) || !read_value(data, read_offset, click.y)) {
+			return false;
+		}
+	}
+	expected_checksum = tick.checksum;
+	ticks++;
+	return true;
+}
+
+bool InputLog::verify(uint64_t checksum)
+{
+	if (checksum == expected_checksum) {
+		return true;
+	}
+	if (first_desync < 0) {
+		first_desync = (int)ticks - 1;
+		std::cerr << "Replay desync at tick " << first_desync << std::endl;
+	}
+	desyncs++;
+	return false;
+}
+
+uint64_t world_checksum()
+{
+	// FNV-1a over the raw bits, so any difference at all shows up
+	uint64_t hash = 1469598103934665603ull;
+	auto mix = [&](float value) {
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		hash = (hash ^ bits) * 1099511628211ull;
+	};
+	auto mixBody = [&](Entity entity) {
+		if (!registry.physicsBodies.has(entity)) {
+			return;
+		}
+		b2BodyId bodyId = registry.physicsBodies.get(entity).bodyId;
+		b2Vec2 position = b2Body_GetPosition(bodyId);
+		b2Vec2 velocity = b2Body_GetLinearVelocity(bodyId);
+		mix(position.x);
+		mix(position.y);
+		mix(velocity.x);
+		mix(velocity.y);
+		mix(b2Body_GetAngularVelocity(bodyId));
+	};
+	for (Entity entity : registry.players.entities) {
+		mixBody(entity);
+	}
+	for (Entity entity : registry.enemies.entities) {
+		mixBody(entity);
+	}
+	hash = (hash ^ registry.enemies.entities.size()) * 1099511628211ull;
+	return hash;
+}
+
+uint16_t pack_control_keys(const std::unordered_map<int, bool> &key_states)
+{
+	uint16_t keys = 0;
+	for (size_t i = 0; i < PLAYER_CONTROL_KEYS.size(); i++) {
+		auto it = key_states.find(PLAYER_CONTROL_KEYS[i]);
+		if (it != key_states.end() && it->second) {
+			keys |= (uint16_t)(1 << i);
+		}
+	}
+	return keys;
+}
+
+void unpack_control_keys(uint16_t keys, std::unordered_map<int, bool> &key_states)
+{
+	for (size_t i = 0; i < PLAYER_CONTROL_KEYS.size(); i++) {
+		key_states[PLAYER_CONTROL_KEYS[i]] = (keys & (1 << i)) != 0;
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Player input recorded per simulated tick, for exact replays and desync hunting.
+//
+// A tick is one frame in which the level is being played (screen PLAYING, game active).
+// For each tick the log stores the frame time it was simulated with, the held
+// PLAYER_CONTROL_KEYS as a bitmask, any grapple clicks (world coordinates) handled just
+// before it, and world_checksum() taken once those clicks are applied. Replaying feeds the
+// same frame times and inputs back in, seeded with the recorded RNG seed, and compares
+// checksums so the first diverging tick is reported.
+//
+// File layout (native endianness): a 24-byte header
+//   "RMRP" | u32 version | i32 level | u32 flags | u64 seed
+// followed by one record per tick
+//   f32 elapsed_ms | u64 checksum | u16 keys | u8 click count | click count x (f32 x, f32 y)
+class InputLog
+{
+public:
+	enum class MODE
+	{
+		OFF,
+		RECORDING,
+		REPLAYING
+	};
+
+	// settings that have to match for a replay to be exact
+	struct Header
+	{
+		int level = 1;
+		uint64_t seed = 0;
+		uint32_t flags = 0;
+	};
+
+	static const uint32_t FLAG_ROPE_MODE = 1 << 0;
+	static const uint32_t FLAG_SWARM_SWARM_CONTACTS = 1 << 1;
+
+	struct Tick
+	{
+		float elapsed_ms = 0.f;
+		uint64_t checksum = 0;
+		uint16_t keys = 0;
+		std::vector<vec2> clicks;
+	};
+
+	~InputLog();
+
+	bool start_recording(const std::string &path, const Header &header);
+	// Reads the whole recording into memory; the header is available right after.
+	bool start_replay(const std::string &path);
+	// Flushes and closes a recording, or drops a replay.
+	void stop();
+
+	MODE mode() const { return current_mode; }
+	bool recording() const { return current_mode == MODE::RECORDING; }
+	bool replaying() const { return current_mode == MODE::REPLAYING; }
+	const Header &header() const { return current_header; }
+
+	// Recording: clicks are held until the tick they lead into is written.
+	void record_click(vec2 world_position);
+	void record_tick(float elapsed_ms, uint64_t checksum, uint16_t keys);
+
+	// Replaying: the next recorded tick, or false once the recording runs out.
+	bool next_tick(Tick &tick);
+
+	// Replaying: compare the live checksum against the current tick; counts mismatches.
+	bool verify(uint64_t checksum);
+
+	// ticks written or read so far
+	unsigned int tick_count() const { return ticks; }
+	unsigned int desync_count() const { return desyncs; }
+	// first tick whose checksum did not match, or -1
+	int first_desync_tick() const { return first_desync; }
+
+private:
+	MODE current_mode = MODE::OFF;
+	Header current_header;
+	std::ofstream out;
+	std::vector<vec2> pending_clicks;
+
+	std::vector<char> data;
+	size_t read_offset = 0;
+	uint64_t expected_checksum = 0;
+
+	unsigned int ticks = 0;
+	unsigned int desyncs = 0;
+	int first_desync = -1;
+};
+
+// Hash of the simulated state (player and enemy bodies) used to detect replay desyncs.
+uint64_t world_checksum();
+
+// PLAYER_CONTROL_KEYS held state <-> bitmask (bit i is PLAYER_CONTROL_KEYS[i])
+uint16_t pack_control_keys(const std::unordered_map<int, bool> &key_states);
+void unpack_control_keys(uint16_t keys, std::unordered_map<int, bool> &key_states);
@@ -0,0 +1,363 @@
+#include "level_loader.hpp"
+#include "world_init.hpp"
+#include "terrain.hpp"
+#include "tile_map.hpp"
+
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <json/json.h>
+
+bool load_level_file(const std::string &filename, b2WorldId worldId, std::vector<LevelSpawn> &spawns)
+{
+  const std::string full_filepath = LEVEL_DIR_FILEPATH + filename;
+  Json::Value mapData;
+
+  std::ifstream infile(full_filepath);
+
+  if (infile.fail())
+  {
+    return false;
+  }
+
+  infile >> mapData;
+
+  // checks to ensure JSON data is the expected format.
+  assert(mapData.find("height") != nullptr);
+  assert(mapData.find("width") != nullptr);
+  assert(mapData.find("layers") != nullptr);
+  assert(mapData["layers"].size() >= 2);
+  assert(mapData["layers"][1]["name"] == "Chain"); // this assert fails if map doesn't have at least 1 chainShape.
+  assert(mapData["layers"][1].find("objects") != nullptr);
+
+  // set stage dimensions
+  WORLD_WIDTH_TILES = mapData["width"].asFloat() / 2;
+  WORLD_HEIGHT_TILES = mapData["height"].asFloat() / 2;
+
+  WORLD_WIDTH_PX = WORLD_WIDTH_TILES * GRID_CELL_WIDTH_PX;
+  WORLD_HEIGHT_PX = WORLD_HEIGHT_TILES * GRID_CELL_HEIGHT_PX;
+
+  // the first tile layer is the level art (drawn by the renderer's tile map when its tilesets are available)
+  level_tile_layer = TileLayer();
+  level_tile_layer_version++;
+  for (const auto &layer : mapData["layers"])
+  {
+    if (layer["type"].asString() != "tilelayer" || !layer["data"].isArray())
+      continue; // base64 or chunked (infinite) layers aren't supported
+
+    level_tile_layer.size = ivec2(layer["width"].asInt(), layer["height"].asInt());
+    level_tile_layer.tile_size = ivec2(mapData["tilewidth"].asInt(), mapData["tileheight"].asInt());
+    level_tile_layer.gids.reserve(layer["data"].size());
+    for (const auto &gid : layer["data"])
+      level_tile_layer.gids.push_back(gid.asUInt());
+    for (const auto &tileset : mapData["tilesets"])
+      level_tile_layer.tilesets.push_back({tileset["firstgid"].asUInt(), tileset["source"].asString()});
+    break;
+  }
+
+  auto &JsonObjects = mapData["layers"][1]["objects"];
+  clear_terrain_chains();
+  bool spawnpoint_found = false;
+  bool goalzone_found = false;
+
+  // Temporary storage for spawn zones and points
+  std::unordered_map<std::string, std::vector<vec2>> spawnZones;
+  std::unordered_map<std::string, std::vector<vec2>> spawnPoints;
+  std::unordered_map<std::string, std::string> enemyType;
+  std::unordered_map<std::string, int> enemyQuantity;
+
+  for (const auto &jsonObj : JsonObjects)
+  {
+    // polyline case
+    if (jsonObj.find(JSON_POLYLINE_ATTR) != nullptr)
+    {
+      std::vector<vec2> chainPoints;
+      const float x_offset = jsonObj["x"].asFloat();
+      const float y_offset = jsonObj["y"].asFloat();
+      const float rotation = jsonObj["rotation"].asFloat() * (M_PI / 180.f);
+
+      for (auto &point : jsonObj[JSON_POLYLINE_ATTR])
+      {
+        float x = point["x"].asFloat();
+        float y = point["y"].asFloat();
+
+        // rotate points
+        if (rotation != 0.f)
+        {
+          vec2 origin = vec2(0.f, 0.f);
+          vec2 rotatedPoint = rotateAroundPoint(vec2(x, y), origin, rotation);
+          x = rotatedPoint.x;
+          y = rotatedPoint.y;
+        }
+
+        chainPoints.push_back(vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset)));
+      }
+
+      std::string name = jsonObj["name"].asString();
+      if (chainPoints.size() == 2 && name.find("SZ") == 0)
+      {
+        // Process enemy spawn zone
+        std::vector<std::string> parts = split(name, "_");
+        if (parts.size() == 2)
+        {
+          std::string id = parts[1];
+          spawnZones[id] = chainPoints;
+          std::cout << "Found enemy spawn ZONE with id: " << id << std::endl;
+        }
+      }
+      else if (chainPoints.size() == 2 && name.find("ENEMY") == 0)
+      {
+        std::cout << "found obstacle enemy spawnpath." << std::endl;
+        std::vector<std::string> parts = split(name, "_");
+        std::vector<vec2> points;
+        std::string id = parts[3];
+
+        const float x_offset = jsonObj["x"].asFloat();
+        const float y_offset = jsonObj["y"].asFloat();
+
+        for (auto &point : jsonObj[JSON_POLYLINE_ATTR])
+        {
+          float x = point["x"].asFloat();
+          float y = point["y"].asFloat();
+          points.push_back(vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset)));
+        }
+
+        spawnPoints[id] = points;
+        enemyType[id] = parts[1];
+        enemyQuantity[id] = std::stoi(parts[2]);
+      }
+      else if (chainPoints.size() == 2 && name == "goal")
+      {
+        std::cout << "found goalpost!" << std::endl;
+        goalzone_found = true;
+
+        bool first = true;
+        vec2 bl_corner;
+        vec2 tr_corner;
+        for (auto &point : jsonObj[JSON_POLYLINE_ATTR])
+        {
+          float x = point["x"].asFloat();
+          float y = point["y"].asFloat();
+
+          if (first)
+          {
+            bl_corner = vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset));
+            first = false;
+          }
+          else
+          {
+            tr_corner = vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset));
+          }
+        }
+
+        createGoalZone(bl_corner, tr_corner);
+      }
+      else if (chainPoints.size() >= 2)
+      {
+        std::cout << "Creating chainShape with " << chainPoints.size() << " segments." << std::endl;
+        if (name == "ledge")
+        {
+          create_chain(chainPoints, false);
+        }
+        else
+        {
+          create_chain(chainPoints, true);
+        }
+      }
+    }
+    // polygon case: polygon = closed-loop chain
+    else if (jsonObj.find(JSON_POLYGON_ATTR) != nullptr)
+    {
+      std::vector<vec2> chainPoints;
+      const float x_offset = jsonObj["x"].asFloat();
+      const float y_offset = jsonObj["y"].asFloat();
+      const float rotation = jsonObj["rotation"].asFloat() * (M_PI / 180.f);
+
+      for (auto &point : jsonObj[JSON_POLYGON_ATTR])
+      {
+        float x = point["x"].asFloat();
+        float y = point["y"].asFloat();
+
+        // rotate enemies_killed
+        if (rotation != 0.f)
+        {
+          vec2 origin = vec2(0.f, 0.f);
+          vec2 rotatedPoint = rotateAroundPoint(vec2(x, y), origin, rotation);
+          x = rotatedPoint.x;
+          y = rotatedPoint.y;
+        }
+
+        chainPoints.push_back(vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset)));
+      }
+
+      std::string name = jsonObj["name"].asString();
+      if (chainPoints.size() == 2 && name.find("SZ") == 0)
+      {
+        // Process enemy spawn zone
+        std::vector<std::string> parts = split(name, "_");
+        if (parts.size() == 2)
+        {
+          std::string id = parts[1];
+          spawnZones[id] = chainPoints;
+          std::cout << "Found enemy spawn ZONE with id: " << id << std::endl;
+        }
+      }
+      else if (chainPoints.size() == 2 && name.find("ENEMY") == 0)
+      {
+        std::cout << "found obstacle enemy spawnpath." << std::endl;
+        std::vector<std::string> parts = split(name, "_");
+        std::vector<vec2> points;
+        std::string id = parts[3];
+
+        const float x_offset = jsonObj["x"].asFloat();
+        const float y_offset = jsonObj["y"].asFloat();
+
+        for (auto &point : jsonObj[JSON_POLYLINE_ATTR])
+        {
+          float x = point["x"].asFloat();
+          float y = point["y"].asFloat();
+          points.push_back(vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset)));
+        }
+
+        spawnPoints[id] = points;
+        enemyType[id] = parts[1];
+        enemyQuantity[id] = std::stoi(parts[2]);
+      }
+      else if (chainPoints.size() == 2 && name == "goal")
+      {
+        std::cout << "found goalpost!" << std::endl;
+        goalzone_found = true;
+
+        bool first = true;
+        vec2 bl_corner;
+        vec2 tr_corner;
+        for (auto &point : jsonObj[JSON_POLYLINE_ATTR])
+        {
+          float x = point["x"].asFloat();
+          float y = point["y"].asFloat();
+
+          if (first)
+          {
+            bl_corner = vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset));
+            first = false;
+          }
+          else
+          {
+            tr_corner = vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset));
+          }
+        }
+
+        createGoalZone(bl_corner, tr_corner);
+      }
+      else if (chainPoints.size() >= 2)
+      {
+        std::cout << "Creating chainShape with " << chainPoints.size() << " segments." << std::endl;
+        if (name == "ledge")
+        {
+          create_chain(chainPoints, false);
+        }
+        else
+        {
+          create_chain(chainPoints, true);
+        }
+      }
+    }
+    // ball_spawnpoint case
+    else if (jsonObj.find("name") != nullptr && jsonObj["name"] == JSON_BALL_SPAWNPOINT)
+    {
+      const float x = jsonObj["x"].asFloat();
+      const float y = jsonObj["y"].asFloat();
+      createBall(worldId, vec2(x, WORLD_HEIGHT_PX - y));
+      spawnpoint_found = true;
+    }
+
+    // enemy spawnpoint case
+    else if (jsonObj.find("name") != nullptr && jsonObj["name"].asString().find("ENEMY") == 0)
+    {
+      std::string name = jsonObj["name"].asString();
+      std::vector<std::string> parts = split(name, "_");
+      if (parts.size() == 4)
+      {
+        std::string id = parts[3];
+        std::vector<vec2> points;
+
+        float x = jsonObj["x"].asFloat();
+        float y = jsonObj["y"].asFloat();
+        points.push_back(vec2(x, WORLD_HEIGHT_PX - y));
+
+        std::cout << "Found enemy spawn POINT with id: " << id << std::endl;
+        spawnPoints[id] = points;
+        enemyType[id] = parts[1];
+        enemyQuantity[id] = std::stoi(parts[2]);
+      }
+    }
+    // grapple point case
+    else if (jsonObj.find("name") != nullptr && jsonObj["name"] == "grapple_point")
+    {
+      const float x = jsonObj["x"].asFloat();
+      const float y = jsonObj["y"].asFloat();
+
+      std::cout << "Found grapple point at: " << x << ", " << y << std::endl;
+      createGrapplePoint(worldId, vec2(x, WORLD_HEIGHT_PX - y));
+    }
+  }
+
+  // Process enemy spawns
+  for (const auto &[id, zone] : spawnZones)
+  {
+    if (spawnPoints.find(id) != spawnPoints.end())
+    {
+      std::vector<vec2> points = spawnPoints[id];
+      ENEMY_TYPES currEnemyType;
+
+      switch (enemyType[id][0])
+      {
+      case 'S':
+        currEnemyType = SWARM;
+        break;
+      case 'C':
+        currEnemyType = COMMON;
+        break;
+      case 'O':
+        currEnemyType = OBSTACLE;
+        break;
+      }
+
+      int quantity = enemyQuantity[id];
+
+      ivec2 bottom_left = ivec2(zone[0].x / TILE_WIDTH, zone[0].y / TILE_HEIGHT);
+      ivec2 top_right = ivec2(zone[1].x / TILE_WIDTH, zone[1].y / TILE_HEIGHT);
+
+      if (currEnemyType == OBSTACLE && points.size() == 2)
+      {
+        vec2 start = points[0];
+        vec2 end = points[1];
+        ivec2 spawn_location = ivec2(start.x / TILE_WIDTH, start.y / TILE_HEIGHT);
+        ivec2 obstacle_patrol_bottom_left = ivec2(start.x / TILE_WIDTH, start.y / TILE_HEIGHT);
+        ivec2 obstacle_patrol_top_right = ivec2(end.x / TILE_WIDTH, end.y / TILE_HEIGHT);
+        spawns.push_back({bottom_left, top_right, currEnemyType, quantity, spawn_location, obstacle_patrol_bottom_left, obstacle_patrol_top_right});
+      }
+      else if (points.size() == 1)
+      {
+        vec2 point = points[0];
+        ivec2 spawn_location = ivec2(point.x / TILE_WIDTH, point.y / TILE_HEIGHT);
+        spawns.push_back({bottom_left, top_right, currEnemyType, quantity, spawn_location, ivec2(0, 0), ivec2(0, 0)});
+      }
+    }
+  }
+
+  if (!spawnpoint_found)
+  {
+    std::cerr << "No spawnpoint found in map file." << std::endl;
+    return false;
+  }
+
+  if (!goalzone_found)
+  {
+    std::cerr << "No goalzone found in map file." << std::endl;
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <box2d/box2d.h>
+#include <string>
+#include <vector>
+
+// An enemy spawn read from a level file. All positions are in grid tiles.
+struct LevelSpawn
+{
+  ivec2 trigger_bottom_left; // spawn fires when the player enters this area
+  ivec2 trigger_top_right;
+  ENEMY_TYPES enemy_type;
+  int quantity;
+  ivec2 spawn_location;
+  ivec2 patrol_point_a; // obstacles only
+  ivec2 patrol_point_b;
+};
+
+// Reads a Tiled map from LEVEL_DIR_FILEPATH: sets the world size, queues the terrain chains
+// (create_static_terrain() builds them), creates the ball, goal zone and grapple points,
+// and returns the enemy spawns. Touches no GL or audio, so the headless benchmark uses it too.
+bool load_level_file(const std::string &filename, b2WorldId worldId, std::vector<LevelSpawn> &spawns);
@@ -0,0 +1,187 @@
+#include "level_tiles.hpp"
+
+#include "../ext/stb_image/stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <json/json.h>
+
+void LevelTileCache::set_capacity(int slots_per_side_arg)
+{
+	slots_per_side = slots_per_side_arg;
+	slots.assign((size_t)slots_per_side * slots_per_side, Slot());
+	resident.clear();
+}
+
+bool LevelTileCache::load(const std::string &image_path)
+{
+	unload();
+
+	const std::string tiles = tile_directory(image_path);
+	std::ifstream infile(manifest_path(tiles));
+	if (infile.fail())
+	{
+		std::cerr << "No tiles for " << image_path << ", build the level_art_tiles target." << std::endl;
+		return false;
+	}
+	Json::Value manifest;
+	infile >> manifest;
+	if (manifest["tile_size"].asInt() != TILE_SIZE || manifest["padding"].asInt() != PADDING)
+	{
+		std::cerr << "The tiles in " << tiles << " were cut for another tile size, build the level_art_tiles target." << std::endl;
+		return false;
+	}
+
+	directory = tiles;
+	size = ivec2(manifest["width"].asInt(), manifest["height"].asInt());
+	tile_count = (size + ivec2(TILE_SIZE - 1)) / TILE_SIZE;
+	return true;
+}
+
+void LevelTileCache::unload()
+{
+	directory.clear();
+	size = ivec2(0);
+	tile_count = ivec2(0);
+	std::fill(slots.begin(), slots.end(), Slot());
+	resident.clear();
+}
+
+int LevelTileCache::acquire(ivec2 tile, std::vector<Upload> &uploads)
+{
+	auto it = resident.find(tile_key(tile));
+	if (it != resident.end())
+	{
+		slots[it->second].last_used = frame;
+		return it->second;
+	}
+
+	// an empty slot, else the least recently used one not needed this frame
+	int victim = -1;
+	for (int i = 0; i < (int)slots.size(); i++)
+	{
+		if (slots[i].last_used == frame)
+			continue;
+		if (victim < 0 || slots[i].last_used < slots[victim].last_used)
+			victim = i;
+		if (slots[i].last_used == 0)
+			break;
+	}
+	if (victim < 0)
+		return -1;
+
+	if (slots[victim].last_used != 0)
+		resident.erase(tile_key(slots[victim].tile));
+	slots[victim] = {tile, frame};
+	resident[tile_key(tile)] = victim;
+	uploads.push_back({tile, slot_origin(victim)});
+	return victim;
+}
+
+void LevelTileCache::update(vec2 view_min, vec2 view_max, vec2 prefetch, int max_prefetch_uploads,
+							std::vector<Tile> &visible, std::vector<Upload> &uploads)
+{
+	visible.clear();
+	uploads.clear();
+	if (directory.empty() || slots.empty())
+		return;
+	frame++;
+
+	auto tile_range = [&](vec2 lo, vec2 hi, ivec2 &first, ivec2 &last) {
+		first = glm::max(ivec2(glm::floor(lo / (float)TILE_SIZE)), ivec2(0));
+		last = glm::min(ivec2(glm::floor(hi / (float)TILE_SIZE)), tile_count - 1);
+	};
+
+	ivec2 first, last;
+	tile_range(view_min, view_max, first, last);
+	const float cache_size = (float)cache_texture_size();
+	for (int ty = first.y; ty <= last.y; ty++)
+	{
+		for (int tx = first.x; tx <= last.x; tx++)
+		{
+			const ivec2 tile = ivec2(tx, ty);
+			const int slot = acquire(tile, uploads);
+			if (slot < 0)
+				continue; // cache smaller than the view, drop the tile rather than thrash
+
+			const ivec2 texel_origin = tile * TILE_SIZE;
+			const ivec2 tile_size = glm::min(ivec2(TILE_SIZE), size - texel_origin);
+			const vec2 uv_min = vec2(slot_origin(slot) + PADDING) / cache_size;
+			const vec2 uv_max = uv_min + vec2(tile_size) / cache_size;
+			visible.push_back({texel_origin, tile_size, {uv_min.x, uv_min.y, uv_max.x, uv_max.y}});
+		}
+	}
+
+	// then the ring around the view: resident ones are kept warm, missing ones are uploaded a few per frame
+	ivec2 prefetch_first, prefetch_last;
+	tile_range(view_min - prefetch, view_max + prefetch, prefetch_first, prefetch_last);
+	const size_t visible_uploads = uploads.size();
+	for (int ty = prefetch_first.y; ty <= prefetch_last.y; ty++)
+	{
+		for (int tx = prefetch_first.x; tx <= prefetch_last.x; tx++)
+		{
+			if (tx >= first.x && tx <= last.x && ty >= first.y && ty <= last.y)
+				continue;
+			const bool resident_already = resident.count(tile_key(ivec2(tx, ty))) > 0;
+			if (!resident_already && (int)(uploads.size() - visible_uploads) >= max_prefetch_uploads)
+				continue;
+			acquire(ivec2(tx, ty), uploads);
+		}
+	}
+}
+
+void LevelTileCache::copy_tile(ivec2 tile, std::vector<uint8_t> &out) const
+{
+	out.assign((size_t)SLOT_SIZE * SLOT_SIZE * 4, 0);
+
+	// rows come out bottom up (stbi_set_flip_vertically_on_load), like the world
+	const std::string path = tile_path(directory, tile);
+	ivec2 file_size;
+	stbi_uc *data = stbi_load(path.c_str(), &file_size.x, &file_size.y, NULL, 4);
+	if (data == NULL || file_size != ivec2(SLOT_SIZE))
+	{
+		std::cerr << "Could not load the level tile " << path << "." << std::endl;
+		stbi_image_free(data);
+		return;
+	}
+	std::memcpy(out.data(), data, out.size());
+	stbi_image_free(data);
+}
+
+std::string LevelTileCache::tile_directory(const std::string &image_path)
+{
+	const size_t slash = image_path.find_last_of('/');
+	const std::string folder = slash == std::string::npos ? "" : image_path.substr(0, slash + 1);
+	const std::string name = image_path.substr(folder.size());
+	return folder + "tiles/" + name.substr(0, name.find_last_of('.')) + "/";
+}
+
+// tile rows count from the bottom of the image, like the world
+std::string LevelTileCache::tile_path(const std::string &directory, ivec2 tile)
+{
+	return directory + std::to_string(tile.x) + "_" + std::to_string(tile.y) + ".png";
+}
+
+void LevelTileCache::cut_slot(const uint8_t *pixels, ivec2 size, ivec2 tile, std::vector<uint8_t> &out)
+{
+	const size_t texel = 4;
+	out.resize((size_t)SLOT_SIZE * SLOT_SIZE * texel);
+
+	const ivec2 origin = tile * TILE_SIZE - PADDING;
+	const int x0 = std::max(origin.x, 0);
+	const int x1 = std::min(origin.x + SLOT_SIZE, size.x);
+	for (int y = 0; y < SLOT_SIZE; y++)
+	{
+		const int src_y = std::clamp(origin.y + y, 0, size.y - 1);
+		const uint8_t *src = pixels + (size_t)src_y * size.x * texel;
+		uint8_t *dst = out.data() + (size_t)y * SLOT_SIZE * texel;
+
+		std::memcpy(dst + (x0 - origin.x) * texel, src + x0 * texel, (size_t)(x1 - x0) * texel);
+		for (int x = 0; x < x0 - origin.x; x++)
+			std::memcpy(dst + x * texel, src, texel);
+		for (int x = x1 - origin.x; x < SLOT_SIZE; x++)
+			std::memcpy(dst + x * texel, src + (size_t)(size.x - 1) * texel, texel);
+	}
+}
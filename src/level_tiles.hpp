@@ -0,0 +1,93 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Level art streamed in tiles. The level image is cut into TILE_SIZE squares ahead of time
+// (ramster_split_level_art, run by the build), one png per slot with its padding already in;
+// only tiles near the camera live in the GL cache texture, a grid of slots_per_side x
+// slots_per_side slots recycled least recently used first, and a tile is decoded from its
+// file only when it is uploaded. VRAM and system memory stay fixed whatever the level size,
+// and no texture ever exceeds GL_MAX_TEXTURE_SIZE.
+//
+// CPU side only: update() decides what is resident and lists the slots to fill, and the
+// renderer uploads them (see RenderSystem::drawLevelTiles).
+class LevelTileCache
+{
+public:
+	static constexpr int TILE_SIZE = 512;
+	// texels copied from the neighbouring tiles around each slot, so linear filtering is seamless
+	static constexpr int PADDING = 1;
+	static constexpr int SLOT_SIZE = TILE_SIZE + 2 * PADDING;
+
+	// A resident tile to draw
+	struct Tile
+	{
+		ivec2 texel_origin; // lower left corner in the level image
+		ivec2 size;			// TILE_SIZE, less at the right and top edges
+		vec4 uv_rect;		// {u0, v0, u1, v1} in the cache texture
+	};
+
+	// A slot to fill with copy_tile() before drawing
+	struct Upload
+	{
+		ivec2 tile;
+		ivec2 slot_origin; // texel offset of the slot in the cache texture
+	};
+
+	void set_capacity(int slots_per_side);
+	int cache_texture_size() const { return slots_per_side * SLOT_SIZE; }
+
+	// Open the tiles of a level image, by the path of the image itself; only their manifest is
+	// read (the previous level and its residency are dropped)
+	bool load(const std::string &image_path);
+	void unload();
+	ivec2 image_size() const { return size; }
+
+	// Tiles overlapping [view_min, view_max] (image texels) are made resident and returned in
+	// visible. Tiles within prefetch of the view are made resident too, at most
+	// max_prefetch_uploads per call, so crossing into them later costs nothing.
+	void update(vec2 view_min, vec2 view_max, vec2 prefetch, int max_prefetch_uploads,
+				std::vector<Tile> &visible, std::vector<Upload> &uploads);
+
+	// RGBA8 texels of a slot (SLOT_SIZE x SLOT_SIZE, rows bottom up) for the given tile, decoded
+	// from its file; transparent if the file can't be read
+	void copy_tile(ivec2 tile, std::vector<uint8_t> &out) const;
+
+	size_t resident_count() const { return resident.size(); }
+
+	// Where the tiles of a level image go: levels/foo.png -> levels/tiles/foo/
+	static std::string tile_directory(const std::string &image_path);
+	static std::string tile_path(const std::string &directory, ivec2 tile);
+	static std::string manifest_path(const std::string &directory) { return directory + "tiles.json"; }
+
+	// The slot of the given tile cut out of a whole decoded image (rows bottom up): the tile plus
+	// PADDING texels of its neighbours, clamped at the image edge. Used to write the tile files.
+	static void cut_slot(const uint8_t *pixels, ivec2 size, ivec2 tile, std::vector<uint8_t> &out);
+
+private:
+	struct Slot
+	{
+		ivec2 tile;
+		uint32_t last_used = 0; // frame; 0 means empty
+	};
+
+	int64_t tile_key(ivec2 tile) const { return ((int64_t)tile.x << 32) ^ (uint32_t)tile.y; }
+	ivec2 slot_origin(int slot) const { return ivec2(slot % slots_per_side, slot / slots_per_side) * SLOT_SIZE; }
+	// slot holding tile, filling one (and queueing its upload) if it isn't resident; -1 when
+	// every slot is already in use this frame
+	int acquire(ivec2 tile, std::vector<Upload> &uploads);
+
+	int slots_per_side = 0;
+	std::vector<Slot> slots;
+	std::unordered_map<int64_t, int> resident; // tile -> slot
+	uint32_t frame = 0;
+
+	std::string directory; // empty while no level is open
+	ivec2 size = ivec2(0);
+	ivec2 tile_count = ivec2(0);
+};
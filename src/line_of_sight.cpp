@@ -0,0 +1,69 @@
+#include "line_of_sight.hpp"
+#include "tinyECS/registry.hpp"
+
+void LineOfSight::request(Entity enemy)
+{
+	// emplace, not operator[]: a default Entity would take a new id
+	auto it = results.find((unsigned int)enemy);
+	if (it == results.end()) {
+		it = results.emplace((unsigned int)enemy, Entry{ enemy, Result() }).first;
+	}
+	Result &result = it->second.result;
+	if (result.queued || (result.valid && result.age_ms < LOS_RESULT_TTL_MS)) {
+		return;
+	}
+	result.queued = true;
+	queue.push_back(enemy);
+}
+
+const LineOfSight::Result *LineOfSight::cached(unsigned int enemy_id) const
+{
+	auto it = results.find(enemy_id);
+	return it == results.end() ? nullptr : &it->second.result;
+}
+
+void LineOfSight::process(b2WorldId worldId, vec2 target, float elapsed_ms, int ray_budget)
+{
+	for (auto it = results.begin(); it != results.end();) {
+		// queued ones are dropped when they come up in the queue
+		if (!it->second.result.queued && !registry.motions.has(it->second.enemy)) {
+			it = results.erase(it);
+			continue;
+		}
+		it->second.result.age_ms += elapsed_ms;
+		++it;
+	}
+
+	b2QueryFilter filter = line_of_sight_query_filter();
+	rays_last_process = 0;
+	while (!queue.empty() && rays_last_process < ray_budget) {
+		Entity enemy = queue.front();
+		queue.pop_front();
+
+		// the enemy may have died while it was waiting
+		if (!registry.motions.has(enemy)) {
+			results.erase((unsigned int)enemy);
+			continue;
+		}
+
+		vec2 origin = registry.motions.get(enemy).position;
+		b2Vec2 translation = { target.x - origin.x, target.y - origin.y };
+		b2RayResult hit = b2World_CastRayClosest(worldId, b2Vec2{ origin.x, origin.y }, translation, filter);
+
+		Result &result = results.find((unsigned int)enemy)->second.result;
+		result.visible = !hit.hit;
+		result.valid = true;
+		result.queued = false;
+		result.age_ms = 0.f;
+
+		rays_last_process++;
+	}
+	total_rays += rays_last_process;
+}
+
+void LineOfSight::clear()
+{
+	results.clear();
+	queue.clear();
+	rays_last_process = 0;
+}
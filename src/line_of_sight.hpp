@@ -0,0 +1,50 @@
+#pragma once
+
+#include "common.hpp"
+#include "tinyECS/tiny_ecs.hpp"
+
+#include <box2d/box2d.h>
+#include <deque>
+#include <unordered_map>
+
+// Enemy -> player visibility, answered by terrain ray casts. Enemies request() every tick,
+// but a request is only queued when the cached answer has expired, and process() casts at
+// most a fixed number of rays per tick (oldest request first). Since an answered enemy goes
+// to the back of the queue the next time it expires, every enemy is revisited round-robin.
+class LineOfSight
+{
+public:
+	struct Result
+	{
+		bool visible = false;
+		bool valid = false;  // false until the first ray for this enemy comes back
+		bool queued = false;
+		float age_ms = 0.f;
+	};
+
+	// Queue a visibility check for this enemy unless one is queued or the cached answer is still fresh.
+	void request(Entity enemy);
+
+	// Last answer for this enemy (by entity id), or nullptr if it was never requested.
+	// Read-only, so it is safe to call from several threads while nothing is requested or processed.
+	const Result *cached(unsigned int enemy_id) const;
+
+	// Drop the answers of dead enemies and age the rest, then cast up to ray_budget rays from queued enemies to target.
+	void process(b2WorldId worldId, vec2 target, float elapsed_ms, int ray_budget);
+
+	// Forget everything (new level).
+	void clear();
+
+	int rays_last_process = 0;
+	long long total_rays = 0;
+	size_t queue_length() const { return queue.size(); }
+
+private:
+	struct Entry
+	{
+		Entity enemy; // kept to check the enemy is still alive
+		Result result;
+	};
+	std::unordered_map<unsigned int, Entry> results;
+	std::deque<Entity> queue;
+};
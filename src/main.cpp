@@ -4,21 +4,47 @@
 #include <box2d/box2d.h>
 
 // stdlib
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
 // internal
 #include "ai_system.hpp"
 #include "world_init.hpp"
 #include "physics_system.hpp"
+#include "render_bench.hpp"
 #include "render_system.hpp"
 #include "world_system.hpp"
 #include "world_init.hpp"
 
 using Clock = std::chrono::high_resolution_clock;
 
-int main()
+int main(int argc, char* argv[])
 {
+	// optional input recording / replay, and the render benchmark:
+	//   ramster --record FILE [--level N]   play level N (default 1) and log the input to FILE
+	//   ramster --replay FILE               play FILE back, reporting any desync
+	//   ramster --bench-render N [--frames F] [--out FILE]   camera flythrough of level N, see render_bench.hpp
+	//   ramster --gl-sync                   (debug builds) report GL errors at the call that caused them
+	std::string record_path, replay_path;
+	int record_level = 1;
+	bool bench_render = false;
+	bool gl_sync = false;
+	RenderBenchOptions bench_options;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--gl-sync") { gl_sync = true; continue; }
+		if (i + 1 >= argc) break;
+		if (arg == "--record") record_path = argv[++i];
+		else if (arg == "--replay") replay_path = argv[++i];
+		else if (arg == "--level") record_level = std::atoi(argv[++i]);
+		else if (arg == "--bench-render") { bench_render = true; bench_options.level = std::atoi(argv[++i]); }
+		else if (arg == "--frames") bench_options.frames = std::max(1, std::atoi(argv[++i]));
+		else if (arg == "--out") bench_options.out = argv[++i];
+	}
+
 	// IMPORTANT! Our change our physics engine to use centimeters.
 	// The default unit for Box2D is meters (1.0f). 
 	// By applying a 100x scaling factor, 
@@ -41,7 +67,7 @@ int main()
 	// global systems
 	WorldSystem   world_system(worldId);
     PhysicsSystem physics_system(worldId);
-    AISystem	  ai_system;
+    AISystem	  ai_system(worldId);
 	RenderSystem  renderer_system;
 
 	// initialize window
@@ -58,9 +84,20 @@ int main()
 	}
 
 	// initialize the main systems
+	renderer_system.synchronous_gl_checks = gl_sync;
 	renderer_system.init(window);
 	world_system.init(&renderer_system);
 
+	if (bench_render) {
+		return run_render_bench(world_system, renderer_system, bench_options);
+	}
+	if (!replay_path.empty()) {
+		world_system.start_replay(replay_path);
+	}
+	else if (!record_path.empty()) {
+		world_system.start_recording(record_path, record_level);
+	}
+
 	// variable timestep loop
 	auto t = Clock::now();
 	while (!world_system.is_over()) {
@@ -74,6 +111,9 @@ int main()
 			(float)(std::chrono::duration_cast<std::chrono::microseconds>(now - t)).count() / 1000;
 		t = now;
 
+		// a replay substitutes the recorded frame time
+		elapsed_ms = world_system.begin_frame(elapsed_ms);
+
 		// CK: be mindful of the order of your systems and rearrange this list only if necessary
 		bool game_active = world_system.step(elapsed_ms);
 		if (game_active) {
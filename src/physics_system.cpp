@@ -2,7 +2,7 @@
 #include "physics_system.hpp"
 #include "world_init.hpp"
 #include <iostream>
-#include "world_system.hpp"
+#include "rope.hpp"
 #include <glm/trigonometric.hpp>
 
 // Constructor
@@ -491,7 +491,7 @@ void PhysicsSystem::step(float elapsed_ms)
 
   if (grappleActive)
   {
-    updateGrappleLines();
+    updateGrappleLines(elapsed_ms);
   }
 
   update_player_animation();
@@ -501,8 +501,11 @@ void PhysicsSystem::step(float elapsed_ms)
   updateScore(camera.position);
 }
 
-void PhysicsSystem::updateGrappleLines()
+void PhysicsSystem::updateGrappleLines(float elapsed_ms)
 {
+  // clamp so a hitch doesn't explode the rope
+  const float step_seconds = std::min(elapsed_ms / 1000.f, 1.f / 30.f);
+
   for (Entity grappleEntity : registry.grapples.entities)
   {
     Grapple &grapple = registry.grapples.get(grappleEntity);
@@ -518,6 +521,14 @@ void PhysicsSystem::updateGrappleLines()
       line.start_pos = vec2(ballPos.x, ballPos.y);
       line.end_pos = vec2(grapplePos.x, grapplePos.y);
     }
+
+    // Or simulate the rope between the same two points
+    if (registry.ropes.has(grappleEntity))
+    {
+      Rope &rope = registry.ropes.get(grappleEntity);
+      float rest_length = b2DistanceJoint_GetLength(grapple.jointId);
+      rope_step(rope, worldId, vec2(ballPos.x, ballPos.y), vec2(grapplePos.x, grapplePos.y), rest_length, step_seconds);
+    }
   }
 }
 
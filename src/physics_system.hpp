@@ -14,7 +14,7 @@ public:
 	void step(float elapsed_ms);
 	explicit PhysicsSystem(b2WorldId worldId);
 	~PhysicsSystem();
-	void updateGrappleLines();
+	void updateGrappleLines(float elapsed_ms);
 	void update_fireball();
 	void update_player_animation();
 	void updateHealthBar(vec2 camPos);
@@ -0,0 +1,162 @@
+#include "render_bench.hpp"
+#include "bench_samples.hpp"
+#include "render_system.hpp"
+#include "world_system.hpp"
+#include "tinyECS/registry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+using Clock = std::chrono::high_resolution_clock;
+
+// frames between issuing a timer query and reading it back, so reading never stalls the pipeline
+const int GPU_QUERY_LATENCY = 4;
+
+// Serpentine over the level: left to right along the top row of screens, down one screen,
+// right to left, and so on. t in [0, 1] maps to distance along the path.
+static vec2 flythrough_position(float t)
+{
+	const float halfW = VIEWPORT_WIDTH_PX / 2.f;
+	const float halfH = VIEWPORT_HEIGHT_PX / 2.f;
+	const float minX = halfW, maxX = std::max(halfW, WORLD_WIDTH_PX - halfW);
+	const float minY = halfH, maxY = std::max(halfH, WORLD_HEIGHT_PX - halfH);
+
+	const int rows = std::max(1, (int)std::ceil((maxY - minY) / VIEWPORT_HEIGHT_PX) + 1);
+	const float rowStep = rows > 1 ? (maxY - minY) / (rows - 1) : 0.f;
+	const float rowLength = maxX - minX;
+	const float total = rows * rowLength + (rows - 1) * rowStep;
+	if (total <= 0.f) {
+		return vec2(minX, minY);
+	}
+
+	float d = t * total;
+	for (int row = 0; row < rows; row++) {
+		float y = maxY - row * rowStep;
+		if (d <= rowLength) {
+			return vec2(row % 2 == 0 ? minX + d : maxX - d, y);
+		}
+		d -= rowLength;
+		if (row + 1 < rows && d <= rowStep) {
+			return vec2(row % 2 == 0 ? maxX : minX, y - d);
+		}
+		d -= rowStep;
+	}
+	return vec2((rows - 1) % 2 == 0 ? maxX : minX, minY);
+}
+
+int run_render_bench(WorldSystem &world, RenderSystem &renderer, const RenderBenchOptions &options)
+{
+	if (!world.start_bench_level(options.level)) {
+		return EXIT_FAILURE;
+	}
+
+	// uncapped: the normal swap interval of 1 would hide anything faster than the refresh rate
+	glfwSwapInterval(0);
+
+	GLuint queries[GPU_QUERY_LATENCY];
+	glGenQueries(GPU_QUERY_LATENCY, queries);
+
+	Samples cpuMs, gpuMs, drawCalls, stateChanges, programBinds, bufferBinds, textureBinds, vertexArrayBinds, glCallsIssued, glCallsSkipped, cullDrawn, cullCulled, levelTilesDrawn, levelTileUploads, tileChunksDrawn;
+	const float frameMs = 1000.f / 60.f;
+	const int totalFrames = options.warmup_frames + options.frames;
+
+	int frame = 0;
+	for (; frame < totalFrames && !world.is_over(); frame++) {
+		glfwPollEvents();
+
+		// warmup frames sit at the start of the path
+		float t = frame < options.warmup_frames ? 0.f : (float)(frame - options.warmup_frames) / std::max(1, options.frames - 1);
+		vec2 cameraPosition = flythrough_position(t);
+		registry.cameras.components[0].position = cameraPosition;
+		// the physics step normally keeps the parallax layer under the camera
+		for (Entity layer : registry.backgroundLayers.entities) {
+			registry.motions.get(layer).position = cameraPosition;
+		}
+
+		GLuint query = queries[frame % GPU_QUERY_LATENCY];
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		auto start = Clock::now();
+		renderer.draw(frameMs, false);
+		double cpu = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		glEndQuery(GL_TIME_ELAPSED);
+
+		// the query issued GPU_QUERY_LATENCY - 1 frames ago is done by now (or close to it)
+		int readFrame = frame - (GPU_QUERY_LATENCY - 1);
+		if (readFrame >= options.warmup_frames) {
+			GLuint64 gpuNs = 0;
+			glGetQueryObjectui64v(queries[readFrame % GPU_QUERY_LATENCY], GL_QUERY_RESULT, &gpuNs);
+			gpuMs.add(gpuNs / 1e6);
+		}
+
+		if (frame >= options.warmup_frames) {
+			cpuMs.add(cpu);
+			drawCalls.add(renderer.stats.draw_calls);
+			stateChanges.add(renderer.stats.state_changes());
+			programBinds.add(renderer.stats.program_binds);
+			bufferBinds.add(renderer.stats.buffer_binds);
+			textureBinds.add(renderer.stats.texture_binds);
+			vertexArrayBinds.add(renderer.stats.vertex_array_binds);
+			glCallsIssued.add(renderer.stats.gl_calls_issued);
+			glCallsSkipped.add(renderer.stats.gl_calls_skipped);
+			cullDrawn.add(renderer.stats.cull_drawn);
+			cullCulled.add(renderer.stats.cull_culled);
+			levelTilesDrawn.add(renderer.stats.level_tiles_drawn);
+			levelTileUploads.add(renderer.stats.level_tile_uploads);
+			tileChunksDrawn.add(renderer.stats.tile_chunks_drawn);
+		}
+	}
+	// the last few queries were never read back
+	for (int readFrame = std::max(options.warmup_frames, frame - (GPU_QUERY_LATENCY - 1)); readFrame < frame; readFrame++) {
+		GLuint64 gpuNs = 0;
+		glGetQueryObjectui64v(queries[readFrame % GPU_QUERY_LATENCY], GL_QUERY_RESULT, &gpuNs);
+		gpuMs.add(gpuNs / 1e6);
+	}
+	glDeleteQueries(GPU_QUERY_LATENCY, queries);
+
+	int fbWidth, fbHeight;
+	glfwGetFramebufferSize(world.getWindow(), &fbWidth, &fbHeight);
+
+	Json::Value root;
+	root["level"] = options.level;
+	root["frames"] = (int)cpuMs.values.size();
+	root["world_px"].append(WORLD_WIDTH_PX);
+	root["world_px"].append(WORLD_HEIGHT_PX);
+	root["framebuffer_px"].append(fbWidth);
+	root["framebuffer_px"].append(fbHeight);
+	root["gl_renderer"] = (const char *)glGetString(GL_RENDERER);
+	root["gl_version"] = (const char *)glGetString(GL_VERSION);
+	root["render_requests"] = (int)registry.renderRequests.entities.size();
+	root["cpu_frame_ms"] = cpuMs.summary();
+	root["gpu_frame_ms"] = gpuMs.summary();
+	root["draw_calls"] = drawCalls.summary();
+	root["state_changes"] = stateChanges.summary();
+	root["state_changes"]["program_binds_mean"] = programBinds.summary()["mean"];
+	root["state_changes"]["buffer_binds_mean"] = bufferBinds.summary()["mean"];
+	root["state_changes"]["texture_binds_mean"] = textureBinds.summary()["mean"];
+	root["state_changes"]["vertex_array_binds_mean"] = vertexArrayBinds.summary()["mean"];
+	root["gl_state_calls"]["issued"] = glCallsIssued.summary();
+	root["gl_state_calls"]["skipped"] = glCallsSkipped.summary();
+	root["culling"]["drawn"] = cullDrawn.summary();
+	root["culling"]["culled"] = cullCulled.summary();
+	root["level_tiles"]["drawn"] = levelTilesDrawn.summary();
+	root["level_tiles"]["uploads"] = levelTileUploads.summary();
+	root["level_tiles"]["tile_map_chunks"] = tileChunksDrawn.summary();
+
+	std::ofstream file(options.out);
+	if (!file) {
+		std::cerr << "bench-render: cannot write " << options.out << std::endl;
+		return EXIT_FAILURE;
+	}
+	Json::StreamWriterBuilder writer;
+	writer["indentation"] = "  ";
+	file << Json::writeString(writer, root) << std::endl;
+
+	std::cout << "bench-render: level " << options.level << ", " << cpuMs.values.size() << " frames, cpu "
+			  << root["cpu_frame_ms"]["mean"].asDouble() << " ms, gpu " << root["gpu_frame_ms"]["mean"].asDouble()
+			  << " ms, " << root["draw_calls"]["mean"].asDouble() << " draw calls, "
+			  << root["state_changes"]["mean"].asDouble() << " state changes per frame -> " << options.out << std::endl;
+	return EXIT_SUCCESS;
+}
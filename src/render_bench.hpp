@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+
+class WorldSystem;
+class RenderSystem;
+
+// `ramster --bench-render <level>`: loads the level with every enemy spawned, freezes
+// gameplay, turns vsync off and flies the camera over the whole map in a fixed
+// serpentine path. Records CPU frame time (draw() including the buffer swap), GPU frame
+// time (GL_TIME_ELAPSED queries), draw calls and state changes per frame, writes a JSON
+// summary and returns the process exit code. The path depends only on the level size and
+// frame count, so runs on the same machine are directly comparable across commits.
+struct RenderBenchOptions
+{
+	int level = 1;
+	int frames = 1800;
+	int warmup_frames = 60;
+	std::string out = "bench_render.json";
+};
+
+int run_render_bench(WorldSystem &world, RenderSystem &renderer, const RenderBenchOptions &options);
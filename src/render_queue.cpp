@@ -0,0 +1,52 @@
+#include "render_queue.hpp"
+
+#include <array>
+#include <utility>
+
+uint64_t RenderQueue::make_key(RENDER_LAYER layer, EFFECT_ASSET_ID effect, GLuint texture, uint32_t depth)
+{
+	const uint64_t state = ((uint64_t)((uint32_t)effect & 0xff) << 16) | (uint64_t)((uint32_t)texture & 0xffff);
+	const uint64_t order = is_opaque(layer) ? (state << 32) | depth : ((uint64_t)depth << 24) | state;
+	return ((uint64_t)((uint32_t)layer & 0xff) << 56) | order;
+}
+
+bool RenderQueue::is_opaque(RENDER_LAYER layer)
+{
+	// grid lines are all the same colour and level tiles sit side by side
+	return layer == RENDER_LAYER::GRID || layer == RENDER_LAYER::LEVEL;
+}
+
+void RenderQueue::submit(RENDER_LAYER layer, EFFECT_ASSET_ID effect, GLuint texture, Entity entity, RENDER_DRAW draw)
+{
+	queue.push_back({make_key(layer, effect, texture, (uint32_t)queue.size()), entity, draw});
+}
+
+void RenderQueue::sort()
+{
+	if (queue.size() < 2)
+		return;
+
+	// copied rather than resized: a default constructed Entity would take a new id
+	scratch = queue;
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		std::array<size_t, 256> offsets = {};
+		for (const RenderItem &item : queue)
+			offsets[(item.key >> shift) & 0xff]++;
+
+		// every key has this byte, nothing would move
+		if (offsets[(queue[0].key >> shift) & 0xff] == queue.size())
+			continue;
+
+		size_t sum = 0;
+		for (size_t &offset : offsets)
+		{
+			size_t count = offset;
+			offset = sum;
+			sum += count;
+		}
+		for (const RenderItem &item : queue)
+			scratch[offsets[(item.key >> shift) & 0xff]++] = item;
+		std::swap(queue, scratch);
+	}
+}
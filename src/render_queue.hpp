@@ -0,0 +1,55 @@
+#pragma once
+
+#include "common.hpp"
+#include "tinyECS/components.hpp"
+#include "tinyECS/tiny_ecs.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Which RenderSystem function draws a queued item
+enum class RENDER_DRAW
+{
+	TEXTURED_MESH,
+	GRID_LINE,
+	LINE,
+	LEVEL_TILES,
+	ROPE,
+	TRAJECTORY_ARC
+};
+
+// One draw for the frame, keyed for sorting
+struct RenderItem
+{
+	uint64_t key;
+	Entity entity;
+	RENDER_DRAW draw;
+};
+
+// The draws of one frame. Layers draw in order, and within a layer the key depends on how it blends:
+//   opaque:  layer (8) | effect (8) | texture (16) | depth (32)
+//   blended: layer (8) | depth (32) | effect (8) | texture (16)
+// Opaque layers group draws by shader then texture, which is what the sprite batch needs to merge
+// them. Blended layers keep submission order, since alpha blending over overlapping sprites
+// depends on it; the batch still merges neighbours that happen to share state. Texture is the GL
+// texture the draw binds (0 for none), so sprites from the same atlas page group together. Depth is
+// the submission index.
+class RenderQueue
+{
+public:
+	static uint64_t make_key(RENDER_LAYER layer, EFFECT_ASSET_ID effect, GLuint texture, uint32_t depth);
+	// layers whose draws never overlap each other, so they can be reordered by state
+	static bool is_opaque(RENDER_LAYER layer);
+
+	void clear() { queue.clear(); }
+	void submit(RENDER_LAYER layer, EFFECT_ASSET_ID effect, GLuint texture, Entity entity, RENDER_DRAW draw);
+
+	// LSD radix sort on the key, a byte per pass; passes where every key has the same byte are skipped
+	void sort();
+
+	const std::vector<RenderItem> &items() const { return queue; }
+
+private:
+	std::vector<RenderItem> queue;
+	std::vector<RenderItem> scratch;
+};
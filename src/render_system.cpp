@@ -10,6 +10,8 @@
 
 void RenderSystem::drawGridLine(Entity entity, const mat3 &projection)
 {
+	flushSprites();
+
 	GridLine &gridLine = registry.gridLines.get(entity);
 	Transform transform;
 
@@ -44,75 +46,113 @@ void RenderSystem::drawGridLine(Entity entity, const mat3 &projection)
 	const GLuint used_effect_enum = (GLuint)render_request.used_effect;
 	assert(used_effect_enum != (GLuint)EFFECT_ASSET_ID::EFFECT_COUNT);
 	const GLuint program = (GLuint)effects[used_effect_enum];
+	const EffectLocations &loc = effect_locations[used_effect_enum];
 
 	// setting shaders
-	glUseProgram(program);
+	useProgram(program);
 	gl_has_errors();
 
 	assert(render_request.used_geometry != GEOMETRY_BUFFER_ID::GEOMETRY_COUNT);
-	const GLuint vbo = vertex_buffers[(GLuint)render_request.used_geometry];
-	const GLuint ibo = index_buffers[(GLuint)render_request.used_geometry];
+	assert(render_request.used_effect == EFFECT_ASSET_ID::LEGACY_EGG && "Type of render request not supported");
 
-	// Setting vertex and index buffers
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	// Setting vertex and index buffers, and the attribute layout
+	bindVertexArray(vertex_arrays[(GLuint)render_request.used_geometry]);
 	gl_has_errors();
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-	gl_has_errors();
-
-	if (render_request.used_effect == EFFECT_ASSET_ID::LEGACY_EGG)
-	{
-		GLint in_position_loc = glGetAttribLocation(program, "in_position");
-		gl_has_errors();
-
-		GLint in_color_loc = glGetAttribLocation(program, "in_color");
-		gl_has_errors();
-
-		glEnableVertexAttribArray(in_position_loc);
-		glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void *)0);
-		gl_has_errors();
-
-		glEnableVertexAttribArray(in_color_loc);
-		glVertexAttribPointer(in_color_loc, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void *)sizeof(vec3));
-		gl_has_errors();
-	}
-	else
-	{
-		assert(false && "Type of render request not supported");
-	}
-
-	// Getting uniform locations for glUniform* calls
-	GLint color_uloc = glGetUniformLocation(program, "fcolor");
+	// Uniform locations were looked up once in initializeGlEffects
+	GLint color_uloc = loc.fcolor;
 	const vec3 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
 	// CK: std::cout << "line color: " << color.r << ", " << color.g << ", " << color.b << std::endl;
 	glUniform3fv(color_uloc, 1, (float *)&color);
 	gl_has_errors();
 
-	// Get number of indices from index buffer, which has elements uint16_t
-	GLint size = 0;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
-	gl_has_errors();
-
-	GLsizei num_indices = size / sizeof(uint16_t);
+	const GLsizei num_indices = index_counts[(GLuint)render_request.used_geometry];
 
-	GLint currProgram;
-	glGetIntegerv(GL_CURRENT_PROGRAM, &currProgram);
 	// Setting uniform values to the currently bound program
-	GLuint transform_loc = glGetUniformLocation(currProgram, "transform");
+	GLint transform_loc = loc.transform;
 	glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float *)&transform.mat);
 	gl_has_errors();
 
-	GLuint projection_loc = glGetUniformLocation(currProgram, "projection");
+	GLint projection_loc = loc.projection;
 	glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float *)&projection);
 	gl_has_errors();
 
 	// Drawing of num_indices/3 triangles specified in the index buffer
 	glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
+	stats.draw_calls++;
+	gl_has_errors();
+}
+
+void RenderSystem::drawRope(Entity entity, const mat3 &projection)
+{
+	const Rope &rope = registry.ropes.get(entity);
+	drawPolyline(rope.x.data(), rope.y.data(), rope.x.size(), 5.0f, vec3(1.0f), projection); // 5px like the grapple line
+}
+
+void RenderSystem::drawTrajectoryArc(Entity entity, const mat3 &projection)
+{
+	const TrajectoryArc &arc = registry.trajectoryArcs.get(entity);
+	std::vector<float> xs(arc.points.size()), ys(arc.points.size());
+	for (size_t i = 0; i < arc.points.size(); i++)
+	{
+		xs[i] = arc.points[i].x;
+		ys[i] = arc.points[i].y;
+	}
+	drawPolyline(xs.data(), ys.data(), xs.size(), 3.0f, vec3(1.0f, 0.85f, 0.3f), projection);
+}
+
+// Draws a polyline as one triangle strip. The vertices are built in world space
+// on the CPU and streamed into the ROPE_STRIP buffer, so a 64 segment rope is one draw call.
+void RenderSystem::drawPolyline(const float *xs, const float *ys, size_t count, float thickness, const vec3 &color, const mat3 &projection)
+{
+	if (count < 2)
+		return;
+
+	flushSprites();
+
+	const float half_thickness = thickness / 2.f;
+	const vec3 white = {1.0f, 1.0f, 1.0f}; // tinted by fcolor
+
+	std::vector<ColoredVertex> strip(count * 2);
+	for (size_t i = 0; i < count; i++)
+	{
+		// tangent from the neighbouring points
+		size_t a = i > 0 ? i - 1 : i;
+		size_t b = i + 1 < count ? i + 1 : i;
+		vec2 tangent = vec2(xs[b] - xs[a], ys[b] - ys[a]);
+		float len = glm::length(tangent);
+		vec2 normal = len > 0.f ? vec2(-tangent.y, tangent.x) * (half_thickness / len) : vec2(0.f, half_thickness);
+
+		strip[2 * i] = {vec3(xs[i] + normal.x, ys[i] + normal.y, 0.5f), white};
+		strip[2 * i + 1] = {vec3(xs[i] - normal.x, ys[i] - normal.y, 0.5f), white};
+	}
+
+	const GLuint program = (GLuint)effects[(GLuint)EFFECT_ASSET_ID::LEGACY_EGG];
+	const EffectLocations &loc = effect_locations[(GLuint)EFFECT_ASSET_ID::LEGACY_EGG];
+	useProgram(program);
+	gl_has_errors();
+
+	bindVertexArray(vertex_arrays[(GLuint)GEOMETRY_BUFFER_ID::ROPE_STRIP]);
+	bindBuffer(GL_ARRAY_BUFFER, vertex_buffers[(GLuint)GEOMETRY_BUFFER_ID::ROPE_STRIP]);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(ColoredVertex) * strip.size(), strip.data(), GL_STREAM_DRAW);
+	gl_has_errors();
+
+	// vertices are already in world space
+	Transform transform;
+	glUniformMatrix3fv(loc.transform, 1, GL_FALSE, (float *)&transform.mat);
+	glUniformMatrix3fv(loc.projection, 1, GL_FALSE, (float *)&projection);
+	glUniform3fv(loc.fcolor, 1, (float *)&color);
+	gl_has_errors();
+
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, (GLsizei)strip.size());
+	stats.draw_calls++;
 	gl_has_errors();
 }
 
 void RenderSystem::drawLine(Entity entity, const mat3 &projection)
 {
+	flushSprites();
+
 	Line &line = registry.lines.get(entity);
 	Transform transform;
 
@@ -140,75 +180,67 @@ void RenderSystem::drawLine(Entity entity, const mat3 &projection)
 	const GLuint used_effect_enum = (GLuint)render_request.used_effect;
 	assert(used_effect_enum != (GLuint)EFFECT_ASSET_ID::EFFECT_COUNT);
 	const GLuint program = (GLuint)effects[used_effect_enum];
+	const EffectLocations &loc = effect_locations[used_effect_enum];
 
 	// Setting shaders
-	glUseProgram(program);
+	useProgram(program);
 	gl_has_errors();
 
 	assert(render_request.used_geometry != GEOMETRY_BUFFER_ID::GEOMETRY_COUNT);
-	const GLuint vbo = vertex_buffers[(GLuint)render_request.used_geometry];
-	const GLuint ibo = index_buffers[(GLuint)render_request.used_geometry];
-
-	// Setting vertex and index buffers
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	gl_has_errors();
+	assert(render_request.used_effect == EFFECT_ASSET_ID::LEGACY_EGG && "Type of render request not supported");
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	// Setting vertex and index buffers, and the attribute layout
+	bindVertexArray(vertex_arrays[(GLuint)render_request.used_geometry]);
 	gl_has_errors();
 
-	if (render_request.used_effect == EFFECT_ASSET_ID::LEGACY_EGG)
-	{
-		GLint in_position_loc = glGetAttribLocation(program, "in_position");
-		gl_has_errors();
-
-		GLint in_color_loc = glGetAttribLocation(program, "in_color");
-		gl_has_errors();
-
-		glEnableVertexAttribArray(in_position_loc);
-		glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE,
-							  sizeof(ColoredVertex), (void *)0);
-		gl_has_errors();
-
-		glEnableVertexAttribArray(in_color_loc);
-		glVertexAttribPointer(in_color_loc, 3, GL_FLOAT, GL_FALSE,
-							  sizeof(ColoredVertex), (void *)sizeof(vec3));
-		gl_has_errors();
-	}
-	else
-	{
-		assert(false && "Type of render request not supported");
-	}
-
-	// Getting uniform locations for glUniform* calls
-	GLint color_uloc = glGetUniformLocation(program, "fcolor");
+	// Uniform locations were looked up once in initializeGlEffects
+	GLint color_uloc = loc.fcolor;
 	const vec3 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
 	glUniform3fv(color_uloc, 1, (float *)&color);
 	gl_has_errors();
 
-	// Get number of indices from index buffer
-	GLint size = 0;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
-	gl_has_errors();
+	const GLsizei num_indices = index_counts[(GLuint)render_request.used_geometry];
 
-	GLsizei num_indices = size / sizeof(uint16_t);
-
-	GLint currProgram;
-	glGetIntegerv(GL_CURRENT_PROGRAM, &currProgram);
 
 	// Setting uniform values
-	GLuint transform_loc = glGetUniformLocation(currProgram, "transform");
+	GLint transform_loc = loc.transform;
 	glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float *)&transform.mat);
 	gl_has_errors();
 
-	GLuint projection_loc = glGetUniformLocation(currProgram, "projection");
+	GLint projection_loc = loc.projection;
 	glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float *)&projection);
 	gl_has_errors();
 
 	// Drawing the line as two triangles forming a rectangle
 	glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
+	stats.draw_calls++;
 	gl_has_errors();
 }
 
+// Steps the animation embedded in a render request, if any. True once a non-looping animation
+// has played out, and the entity should go.
+bool RenderSystem::advanceAnimation(RenderRequest &render_request, float elapsed_ms)
+{
+	if (render_request.animation_frames.empty() || !render_request.is_visible)
+		return false;
+
+	render_request.animation_elapsed_time += elapsed_ms;
+
+	if (!render_request.is_loop &&
+		render_request.animation_current_frame >= render_request.animation_frames.size())
+		return true;
+
+	// if enough time has passed, switch frames
+	if (render_request.animation_elapsed_time >= render_request.animation_frame_time)
+	{
+		render_request.animation_elapsed_time = 0;
+		render_request.animation_current_frame += 1;
+		int access_index = render_request.animation_current_frame % render_request.animation_frames.size();
+		render_request.used_texture = render_request.animation_frames[access_index];
+	}
+	return false;
+}
+
 void RenderSystem::drawTexturedMesh(Entity entity, const mat3 &projection, float elapsed_ms, bool game_active)
 {
 	// Transformation code, see Rendering and Transformation in the template
@@ -249,43 +281,64 @@ void RenderSystem::drawTexturedMesh(Entity entity, const mat3 &projection, float
 		return;
 	}
 
-	if (!render_request.animation_frames.empty() && game_active && render_request.is_visible)
+	if (game_active && advanceAnimation(render_request, elapsed_ms))
 	{
-		render_request.animation_elapsed_time += elapsed_ms;
+		// not a looping animation and it is already complete, remove it
+		registry.remove_all_components_of(entity);
+		return;
+	}
 
-		// if this is not a looping animation and it is already complete, remove it
-		if (!render_request.is_loop &&
-			render_request.animation_current_frame >= render_request.animation_frames.size())
+	// textured sprites only differ in per-instance data, so they go into the batch
+	if (render_request.used_geometry == GEOMETRY_BUFFER_ID::SPRITE &&
+		(render_request.used_effect == EFFECT_ASSET_ID::TEXTURED ||
+		 render_request.used_effect == EFFECT_ASSET_ID::TRANSLUCENT ||
+		 render_request.used_effect == EFFECT_ASSET_ID::FIREBALL ||
+		 render_request.used_effect == EFFECT_ASSET_ID::RAMSTER))
+	{
+		vec4 uv_rect = {0.f, 0.f, 1.f, 1.f};
+		float alpha = 1.f;
+		if (render_request.used_effect == EFFECT_ASSET_ID::TRANSLUCENT)
 		{
-			registry.remove_all_components_of(entity);
-			return;
+			alpha = 0.25f;
 		}
-
-		// if enough time has passed, switch frames
-		if (render_request.animation_elapsed_time >= render_request.animation_frame_time)
+		else if (render_request.used_effect == EFFECT_ASSET_ID::FIREBALL)
+		{
+			alpha = 0.50f;
+		}
+		else if (render_request.used_effect == EFFECT_ASSET_ID::RAMSTER)
 		{
-			render_request.animation_elapsed_time = 0;
-			render_request.animation_current_frame += 1;
-			int access_index = render_request.animation_current_frame % render_request.animation_frames.size();
-			render_request.used_texture = render_request.animation_frames[access_index];
+			// face the direction of travel
+			Entity playerEntity_physicsBody = registry.players.entities[0];
+			b2BodyId playerBodyID = registry.physicsBodies.get(playerEntity_physicsBody).bodyId;
+			if (b2Body_GetLinearVelocity(playerBodyID).x < -0.1f)
+				uv_rect = {1.f, 0.f, 0.f, 1.f};
 		}
+
+		// uv_rect is in image space, map it onto the image's rect in its atlas page
+		const vec4 &atlas_rect = texture_uv_rects[(GLuint)render_request.used_texture];
+		uv_rect = {glm::mix(atlas_rect.x, atlas_rect.z, uv_rect.x), glm::mix(atlas_rect.y, atlas_rect.w, uv_rect.y),
+				   glm::mix(atlas_rect.x, atlas_rect.z, uv_rect.z), glm::mix(atlas_rect.y, atlas_rect.w, uv_rect.w)};
+
+		const vec3 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
+		queueSprite(transform, texture_gl_handles[(GLuint)render_request.used_texture], uv_rect, vec4(color, alpha), projection);
+		return;
 	}
 
+	flushSprites();
+
 	const GLuint used_effect_enum = (GLuint)render_request.used_effect;
 	assert(used_effect_enum != (GLuint)EFFECT_ASSET_ID::EFFECT_COUNT);
 	const GLuint program = (GLuint)effects[used_effect_enum];
+	const EffectLocations &loc = effect_locations[used_effect_enum];
 
 	// Setting shaders
-	glUseProgram(program);
+	useProgram(program);
 	gl_has_errors();
 
 	assert(render_request.used_geometry != GEOMETRY_BUFFER_ID::GEOMETRY_COUNT);
-	const GLuint vbo = vertex_buffers[(GLuint)render_request.used_geometry];
-	const GLuint ibo = index_buffers[(GLuint)render_request.used_geometry];
 
-	// Setting vertex and index buffers
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	// Setting vertex and index buffers, and the attribute layout
+	bindVertexArray(vertex_arrays[(GLuint)render_request.used_geometry]);
 	gl_has_errors();
 
 	// texture-mapped entities - use data location as in the vertex buffer
@@ -293,112 +346,62 @@ void RenderSystem::drawTexturedMesh(Entity entity, const mat3 &projection, float
 		render_request.used_effect == EFFECT_ASSET_ID::TRANSLUCENT ||
 		render_request.used_effect == EFFECT_ASSET_ID::FIREBALL)
 	{
-		GLint in_position_loc = glGetAttribLocation(program, "in_position");
-		GLint in_texcoord_loc = glGetAttribLocation(program, "in_texcoord");
-		gl_has_errors();
-		assert(in_texcoord_loc >= 0);
-
-		glEnableVertexAttribArray(in_position_loc);
-		glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE,
-							  sizeof(TexturedVertex), (void *)0);
-		gl_has_errors();
-
-		glEnableVertexAttribArray(in_texcoord_loc);
-		glVertexAttribPointer(
-			in_texcoord_loc, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex),
-			(void *)sizeof(
-				vec3)); // note the stride to skip the preceeding vertex position
-
 		// Enabling and binding texture to slot 0
-		glActiveTexture(GL_TEXTURE0);
+		activeTexture(GL_TEXTURE0);
 		gl_has_errors();
 
 		assert(registry.renderRequests.has(entity));
-		GLuint texture_id =
-			texture_gl_handles[(GLuint)registry.renderRequests.get(entity).used_texture];
+		GLuint texture_id = standaloneTexture(registry.renderRequests.get(entity).used_texture);
 
-		glBindTexture(GL_TEXTURE_2D, texture_id);
+		bindTexture(texture_id);
 		gl_has_errors();
 
 		float translucency_factor = 0.25f;
-		GLint translucency_factor_loc = glGetUniformLocation(program, "translucent_alpha");
+		GLint translucency_factor_loc = loc.translucent_alpha;
 		glUniform1f(translucency_factor_loc, translucency_factor);
 		gl_has_errors();
 
 		float fireball_factor = 0.50f;
-		GLint fireball_factor_loc = glGetUniformLocation(program, "fireball_alpha");
+		GLint fireball_factor_loc = loc.fireball_alpha;
 		glUniform1f(fireball_factor_loc, fireball_factor);
 		gl_has_errors();
 	}
 	else if (render_request.used_effect == EFFECT_ASSET_ID::PARALLAX)
 	{
-		GLint in_position_loc = glGetAttribLocation(program, "in_position");
-		GLint in_texcoord_loc = glGetAttribLocation(program, "in_texcoord");
-		gl_has_errors();
-		assert(in_texcoord_loc >= 0);
-
-		glEnableVertexAttribArray(in_position_loc);
-		glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE,
-							  sizeof(TexturedVertex), (void *)0);
-		gl_has_errors();
-
-		glEnableVertexAttribArray(in_texcoord_loc);
-		glVertexAttribPointer(in_texcoord_loc, 2, GL_FLOAT, GL_FALSE,
-							  sizeof(TexturedVertex), (void *)sizeof(vec3));
-		gl_has_errors();
-
 		// Enable and bind texture
-		glActiveTexture(GL_TEXTURE0);
+		activeTexture(GL_TEXTURE0);
 		gl_has_errors();
 
-		GLuint texture_id =
-			texture_gl_handles[(GLuint)registry.renderRequests.get(entity).used_texture];
-		glBindTexture(GL_TEXTURE_2D, texture_id);
+		GLuint texture_id = standaloneTexture(registry.renderRequests.get(entity).used_texture);
+		bindTexture(texture_id);
 		gl_has_errors();
 
 		// Parallax-specific uniforms
 		Camera camera = registry.cameras.components[0];
-		GLint camera_pos_loc = glGetUniformLocation(program, "camera_pos");
+		GLint camera_pos_loc = loc.camera_pos;
 		glUniform2fv(camera_pos_loc, 1, (float *)&camera.position);
 		gl_has_errors();
 
 		float parallax_factor = 0.1f;
-		GLint parallax_factor_loc = glGetUniformLocation(program, "parallax_factor");
+		GLint parallax_factor_loc = loc.parallax_factor;
 		glUniform1f(parallax_factor_loc, parallax_factor);
 		gl_has_errors();
 
 		vec2 texture_size = vec2(640.0f, 564.0f);
-		GLint tex_size_loc = glGetUniformLocation(program, "texture_size");
+		GLint tex_size_loc = loc.texture_size;
 		glUniform2fv(tex_size_loc, 1, (float *)&texture_size);
 		gl_has_errors();
 	}
 	else if (render_request.used_effect == EFFECT_ASSET_ID::RAMSTER)
 	{
-		GLint in_position_loc = glGetAttribLocation(program, "in_position");
-		GLint in_texcoord_loc = glGetAttribLocation(program, "in_texcoord");
-		gl_has_errors();
-		assert(in_texcoord_loc >= 0);
-
-		glEnableVertexAttribArray(in_position_loc);
-		glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE,
-							  sizeof(TexturedVertex), (void *)0);
-		gl_has_errors();
-
-		glEnableVertexAttribArray(in_texcoord_loc);
-		glVertexAttribPointer(
-			in_texcoord_loc, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex),
-			(void *)sizeof(
-				vec3)); // note the stride to skip the preceeding vertex position
-
 		// Enabling and binding texture to slot 0
-		glActiveTexture(GL_TEXTURE0);
+		activeTexture(GL_TEXTURE0);
 		gl_has_errors();
 
 		assert(registry.renderRequests.has(entity));
-		GLuint texture_id =
-			texture_gl_handles[(GLuint)registry.renderRequests.get(entity).used_texture];
+		GLuint texture_id = standaloneTexture(registry.renderRequests.get(entity).used_texture);
 
-		glBindTexture(GL_TEXTURE_2D, texture_id);
+		bindTexture(texture_id);
 		gl_has_errors();
 
 		Entity playerEntity_physicsBody = registry.players.entities[0];
@@ -407,69 +410,133 @@ void RenderSystem::drawTexturedMesh(Entity entity, const mat3 &projection, float
 		b2Vec2 velocity = b2Body_GetLinearVelocity(playerBodyID);
 
 		bool flipTextureX = velocity.x < -0.1f;
-		GLint flip_loc = glGetUniformLocation(program, "u_flipTextureX");
+		GLint flip_loc = loc.flip_texture_x;
 		glUniform1i(flip_loc, flipTextureX ? 1 : 0);
 		gl_has_errors();
 	}
 	// .obj entities
 	else if (render_request.used_effect == EFFECT_ASSET_ID::LEGACY_CHICKEN || render_request.used_effect == EFFECT_ASSET_ID::LEGACY_EGG)
 	{
-		GLint in_position_loc = glGetAttribLocation(program, "in_position");
-		GLint in_color_loc = glGetAttribLocation(program, "in_color");
-		gl_has_errors();
-
-		glEnableVertexAttribArray(in_position_loc);
-		glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE,
-							  sizeof(ColoredVertex), (void *)0);
-		gl_has_errors();
-
-		glEnableVertexAttribArray(in_color_loc);
-		glVertexAttribPointer(in_color_loc, 3, GL_FLOAT, GL_FALSE,
-							  sizeof(ColoredVertex), (void *)sizeof(vec3));
-		gl_has_errors();
+		// vertex colors only, nothing to bind
 	}
 	else
 	{
 		assert(false && "Type of render request not supported");
 	}
 
-	// Getting uniform locations for glUniform* calls
-	GLint color_uloc = glGetUniformLocation(program, "fcolor");
+	// Uniform locations were looked up once in initializeGlEffects
+	GLint color_uloc = loc.fcolor;
 	const vec3 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
 	glUniform3fv(color_uloc, 1, (float *)&color);
 	gl_has_errors();
 
-	// Get number of indices from index buffer, which has elements uint16_t
-	GLint size = 0;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
-	gl_has_errors();
-
-	GLsizei num_indices = size / sizeof(uint16_t);
-	// GLsizei num_triangles = num_indices / 3;
+	const GLsizei num_indices = index_counts[(GLuint)render_request.used_geometry];
 
-	GLint currProgram;
-	glGetIntegerv(GL_CURRENT_PROGRAM, &currProgram);
 	// Setting uniform values to the currently bound program
-	GLuint transform_loc = glGetUniformLocation(currProgram, "transform");
+	GLint transform_loc = loc.transform;
 	glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float *)&transform.mat);
 	gl_has_errors();
 
-	GLuint projection_loc = glGetUniformLocation(currProgram, "projection");
+	GLint projection_loc = loc.projection;
 	glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float *)&projection);
 	gl_has_errors();
 
 	// Drawing of num_indices/3 triangles specified in the index buffer
 	glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
+	stats.draw_calls++;
 	gl_has_errors();
 }
 
+// Levels whose tile layer can be built draw it as tile map chunks; the others open their tile
+// files for the tile cache. A restart of the same level keeps the resident tiles.
+void RenderSystem::loadLevelArt(TEXTURE_ASSET_ID level_texture)
+{
+	if (tile_map_version != level_tile_layer_version)
+	{
+		// the level layer is stretched over the world (createLevelTextureLayer), and so is the tile layer
+		tile_map_version = level_tile_layer_version;
+		const TileLayer &layer = level_tile_layer;
+		const vec2 layer_px = vec2(layer.size * layer.tile_size);
+		tile_map_ready = layer_px.x > 0 && layer_px.y > 0 && buildTileMap(vec2(0.f), vec2(WORLD_WIDTH_PX, WORLD_HEIGHT_PX) / layer_px);
+	}
+	if (tile_map_ready)
+	{
+		level_tiles.unload();
+		level_tiles_source = TEXTURE_ASSET_ID::TEXTURE_COUNT;
+		return;
+	}
+
+	if (level_texture != level_tiles_source)
+	{
+		level_tiles.load(texture_paths[(GLuint)level_texture]);
+		level_tiles_source = level_texture;
+	}
+}
+
+// The level art, from what loadLevelArt() prepared: the tile map chunks, or the tiles of the
+// level png the camera can see, from the tile cache in one batch. Tiles that came into view
+// (or into the prefetch margin around it) are uploaded first.
+void RenderSystem::drawLevelTiles(Entity entity, const mat3 &projection)
+{
+	const RenderRequest &render_request = registry.renderRequests.get(entity);
+	if (!render_request.is_visible)
+		return;
+
+	if (tile_map_ready)
+	{
+		drawTileMap(projection);
+		return;
+	}
+	if (render_request.used_texture != level_tiles_source || level_tiles.image_size() == ivec2(0))
+		return;
+
+	// the image is stretched over the motion's rect
+	const Motion &motion = registry.motions.get(entity);
+	const vec2 world_min = motion.position - motion.scale / 2.f;
+	const vec2 texels_per_px = vec2(level_tiles.image_size()) / motion.scale;
+
+	vec2 view_min, view_max;
+	getCameraBounds(view_min, view_max);
+	level_tiles.update((view_min - world_min) * texels_per_px, (view_max - world_min) * texels_per_px,
+					   LEVEL_TILE_PREFETCH_PX * texels_per_px, LEVEL_TILE_PREFETCH_UPLOADS,
+					   level_tiles_visible, level_tile_uploads);
+
+	if (!level_tile_uploads.empty())
+	{
+		flushSprites();
+		activeTexture(GL_TEXTURE0);
+		bindTexture(level_tile_texture);
+		for (const LevelTileCache::Upload &upload : level_tile_uploads)
+		{
+			level_tiles.copy_tile(upload.tile, level_tile_pixels);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, upload.slot_origin.x, upload.slot_origin.y,
+							LevelTileCache::SLOT_SIZE, LevelTileCache::SLOT_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, level_tile_pixels.data());
+			gl_has_errors();
+		}
+		stats.level_tile_uploads = (int)level_tile_uploads.size();
+	}
+
+	const vec3 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
+	for (const LevelTileCache::Tile &tile : level_tiles_visible)
+	{
+		Transform transform;
+		transform.translate(world_min + (vec2(tile.texel_origin) + vec2(tile.size) / 2.f) / texels_per_px);
+		transform.scale(vec2(tile.size) / texels_per_px);
+		queueSprite(transform, level_tile_texture, tile.uv_rect, vec4(color, 1.f), projection);
+	}
+	stats.level_tiles_drawn = (int)level_tiles_visible.size();
+}
+
 // first draw to an intermediate texture,
 // apply the "vignette" texture, when requested
 // then draw the intermediate texture
 void RenderSystem::drawToScreen()
 {
+	// the last sprites of the frame are still queued
+	flushSprites();
+
 	// --- SET SHADER ---
-	glUseProgram(effects[(GLuint)EFFECT_ASSET_ID::VIGNETTE]);
+	useProgram(effects[(GLuint)EFFECT_ASSET_ID::VIGNETTE]);
 	gl_has_errors();
 
 	// --- GET ACTUAL WINDOW SIZE ---
@@ -503,45 +570,39 @@ void RenderSystem::drawToScreen()
 
 	// --- CLEAR & SETUP SCREEN ---
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glViewport(viewport_x, viewport_y, viewport_w, viewport_h);
+	setViewport(viewport_x, viewport_y, viewport_w, viewport_h);
 	glDepthRange(0, 10);
 	glClearColor(0.f, 0.f, 0.f, 1.0f); // black bars
 	glClearDepth(1.f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glDisable(GL_BLEND);
-	glDisable(GL_DEPTH_TEST);
+	setCapability(GL_BLEND, false);
+	setCapability(GL_DEPTH_TEST, false);
 	gl_has_errors();
 
 	// --- SET GEOMETRY ---
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[(GLuint)GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE]);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers[(GLuint)GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE]);
+	bindVertexArray(vertex_arrays[(GLuint)GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE]);
 	gl_has_errors();
 
 	// --- UNIFORMS ---
-	const GLuint vignette_program = effects[(GLuint)EFFECT_ASSET_ID::VIGNETTE];
+	const EffectLocations &loc = effect_locations[(GLuint)EFFECT_ASSET_ID::VIGNETTE];
 
-	GLuint time_uloc = glGetUniformLocation(vignette_program, "time");
+	GLint time_uloc = loc.time;
 	glUniform1f(time_uloc, (float)(glfwGetTime() * 10.0f));
 
 	ScreenState &screen = registry.screenStates.get(screen_state_entity);
-	glUniform1f(glGetUniformLocation(vignette_program, "darken_screen_factor"), screen.darken_screen_factor);
-	glUniform1f(glGetUniformLocation(vignette_program, "apply_vignette"), screen.vignette);
-	glUniform1f(glGetUniformLocation(vignette_program, "apply_fadeout"), screen.fadeout);
-	gl_has_errors();
-
-	// --- VERTEX ATTRIB ---
-	GLint in_position_loc = glGetAttribLocation(vignette_program, "in_position");
-	glEnableVertexAttribArray(in_position_loc);
-	glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void *)0);
+	glUniform1f(loc.darken_screen_factor, screen.darken_screen_factor);
+	glUniform1f(loc.apply_vignette, screen.vignette);
+	glUniform1f(loc.apply_fadeout, screen.fadeout);
 	gl_has_errors();
 
 	// --- TEXTURE ---
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, off_screen_render_buffer_color);
+	activeTexture(GL_TEXTURE0);
+	bindTexture(off_screen_render_buffer_color);
 	gl_has_errors();
 
 	// --- DRAW ---
 	glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_SHORT, nullptr);
+	stats.draw_calls++;
 	gl_has_errors();
 }
 
@@ -549,6 +610,10 @@ void RenderSystem::drawToScreen()
 // http://www.opengl-tutorial.org/intermediate-tutorials/tutorial-14-render-to-texture/
 void RenderSystem::draw(float elapsed_ms, bool game_active)
 {
+	stats = RenderStats();
+	// init, resize and the benchmark touch GL directly, so start each frame from unknown state
+	gl_state = GlStateCache();
+
 	// Getting size of window
 	int w, h;
 	glfwGetFramebufferSize(window, &w, &h); // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
@@ -558,7 +623,7 @@ void RenderSystem::draw(float elapsed_ms, bool game_active)
 	gl_has_errors();
 
 	// clear backbuffer
-	glViewport(0, 0, w, h);
+	setViewport(0, 0, w, h);
 	glDepthRange(0.00001, 10);
 
 	// black background
@@ -566,9 +631,9 @@ void RenderSystem::draw(float elapsed_ms, bool game_active)
 
 	glClearDepth(10.f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glEnable(GL_BLEND);
+	setCapability(GL_BLEND, true);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glDisable(GL_DEPTH_TEST); // native OpenGL does not work with a depth buffer
+	setCapability(GL_DEPTH_TEST, false); // native OpenGL does not work with a depth buffer
 	// and alpha blending, one would have to sort
 	// sprites back to front
 	gl_has_errors();
@@ -581,97 +646,109 @@ void RenderSystem::draw(float elapsed_ms, bool game_active)
 	// RENDER WHEN PLAYING
 	if (currentScreen.current_screen == "PLAYING")
 	{
-		// draw grid lines first
-		for (Entity entity : registry.renderRequests.entities)
-		{
-			if (registry.gridLines.has(entity))
-			{
-				drawGridLine(entity, projection_2D);
-			}
-		}
-
-		// draw the background layer
-		for (Entity entity : registry.renderRequests.entities)
+		// animations first, so sprites the camera can't see keep animating too
+		if (game_active)
 		{
-			if (registry.motions.has(entity) && registry.backgroundLayers.has(entity))
+			finished_animations.clear();
+			for (size_t i = 0; i < registry.renderRequests.entities.size(); i++)
 			{
-				drawTexturedMesh(entity, projection_2D, elapsed_ms, game_active);
+				RenderRequest &rr = registry.renderRequests.components[i];
+				if (rr.layer != RENDER_LAYER::SCREEN && advanceAnimation(rr, elapsed_ms))
+					finished_animations.push_back(registry.renderRequests.entities[i]);
 			}
+			for (Entity entity : finished_animations)
+				registry.remove_all_components_of(entity);
 		}
 
-		// draw all entities (except player entities) with a render request to the frame buffer
-		std::vector<Entity> playerBackLayer;
-		std::vector<Entity> playerMidLayer;
-		std::vector<Entity> playerTopLayer;
-		std::vector<Entity> fireballs;
-		std::vector<Entity> overlay;
-		for (Entity entity : registry.renderRequests.entities)
+		// one pass to queue everything, then draw in key order (see RenderQueue)
+		render_queue.clear();
+		vec2 view_min, view_max;
+		getCameraBounds(view_min, view_max);
+		for (size_t i = 0; i < registry.renderRequests.entities.size(); i++)
 		{
-			RenderRequest &rr = registry.renderRequests.get(entity);
+			Entity entity = registry.renderRequests.entities[i];
+			const RenderRequest &rr = registry.renderRequests.components[i];
 
-			// collect player related entities for processing later
-			if (registry.playerBottomLayer.has(entity))
-			{
-				playerBackLayer.push_back(entity);
-				continue;
-			}
-			if (registry.playerMidLayer.has(entity))
-			{
-				playerMidLayer.push_back(entity);
-				continue;
-			}
-			if (registry.playerTopLayer.has(entity))
+			switch (rr.layer)
 			{
-				playerTopLayer.push_back(entity);
-				continue;
-			}
-			if (registry.fireballs.has(entity))
-			{
-				fireballs.push_back(entity);
-				continue;
-			}
-			if (registry.uis.has(entity))
-			{
-				overlay.push_back(entity);
-				continue;
-			}
-			// filter to entities that have a motion component (but not a screen)
-			if (registry.motions.has(entity) && !registry.screens.has(entity) && !registry.backgroundLayers.has(entity) && !registry.screenElements.has(entity))
-			{
-				// Note, its not very efficient to access elements indirectly via the entity
-				// albeit iterating through all Sprites in sequence. A good point to optimize
-				drawTexturedMesh(entity, projection_2D, elapsed_ms, game_active);
-			}
-			// draw terrain lines separately
-			else if (registry.lines.has(entity))
-			{
-				drawLine(entity, projection_2D);
+			case RENDER_LAYER::SCREEN:
+				break; // menus and story only
+			case RENDER_LAYER::GRID:
+				render_queue.submit(rr.layer, rr.used_effect, textureHandle(rr.used_texture), entity, RENDER_DRAW::GRID_LINE);
+				break;
+			case RENDER_LAYER::LINES:
+				render_queue.submit(rr.layer, rr.used_effect, textureHandle(rr.used_texture), entity, RENDER_DRAW::LINE);
+				break;
+			case RENDER_LAYER::LEVEL:
+				if (registry.levelLayers.has(entity))
+				{
+					render_queue.submit(rr.layer, rr.used_effect, level_tile_texture, entity, RENDER_DRAW::LEVEL_TILES);
+					break;
+				}
+				[[fallthrough]];
+			case RENDER_LAYER::WORLD:
+			case RENDER_LAYER::PLAYER_BACK:
+			case RENDER_LAYER::PLAYER_MID:
+			case RENDER_LAYER::PLAYER_TOP:
+			case RENDER_LAYER::FIREBALLS:
+				// placed in world space, so only submitted if the camera can see them;
+				// half the diagonal covers the quad at any rotation
+				if (registry.motions.has(entity))
+				{
+					const Motion &motion = registry.motions.get(entity);
+					const vec2 half_extent = vec2(0.5f * length(motion.scale));
+					if (any(greaterThan(motion.position - half_extent, view_max)) || any(lessThan(motion.position + half_extent, view_min)))
+					{
+						stats.cull_culled++;
+						break;
+					}
+					stats.cull_drawn++;
+					render_queue.submit(rr.layer, rr.used_effect, textureHandle(rr.used_texture), entity, RENDER_DRAW::TEXTURED_MESH);
+				}
+				break;
+			default:
+				if (registry.motions.has(entity))
+					render_queue.submit(rr.layer, rr.used_effect, textureHandle(rr.used_texture), entity, RENDER_DRAW::TEXTURED_MESH);
+				break;
 			}
 		}
 
-		for (Entity entity : playerBackLayer)
-		{
-			drawTexturedMesh(entity, projection_2D, elapsed_ms, game_active);
-		}
-
-		for (Entity entity : playerMidLayer)
+		// grapple ropes go under the player layers, like the grapple line
+		for (Entity entity : registry.ropes.entities)
 		{
-			drawTexturedMesh(entity, projection_2D, elapsed_ms, game_active);
+			render_queue.submit(RENDER_LAYER::ROPES, EFFECT_ASSET_ID::LEGACY_EGG, 0, entity, RENDER_DRAW::ROPE);
 		}
-
-		for (Entity entity : playerTopLayer)
+		for (Entity entity : registry.trajectoryArcs.entities)
 		{
-			drawTexturedMesh(entity, projection_2D, elapsed_ms, game_active);
+			render_queue.submit(RENDER_LAYER::ROPES, EFFECT_ASSET_ID::LEGACY_EGG, 0, entity, RENDER_DRAW::TRAJECTORY_ARC);
 		}
 
-		for (Entity entity : fireballs)
-		{
-			drawTexturedMesh(entity, projection_2D, elapsed_ms, game_active);
-		}
+		render_queue.sort();
 
-		for (Entity entity : overlay)
+		for (const RenderItem &item : render_queue.items())
 		{
-			drawTexturedMesh(entity, projection_2D, elapsed_ms, game_active);
+			switch (item.draw)
+			{
+			case RENDER_DRAW::TEXTURED_MESH:
+				// animations were advanced above
+				drawTexturedMesh(item.entity, projection_2D, elapsed_ms, false);
+				break;
+			case RENDER_DRAW::GRID_LINE:
+				drawGridLine(item.entity, projection_2D);
+				break;
+			case RENDER_DRAW::LINE:
+				drawLine(item.entity, projection_2D);
+				break;
+			case RENDER_DRAW::LEVEL_TILES:
+				drawLevelTiles(item.entity, projection_2D);
+				break;
+			case RENDER_DRAW::ROPE:
+				drawRope(item.entity, projection_2D);
+				break;
+			case RENDER_DRAW::TRAJECTORY_ARC:
+				drawTrajectoryArc(item.entity, projection_2D);
+				break;
+			}
 		}
 	}
 	// STORY SCREENS
@@ -767,6 +844,156 @@ void RenderSystem::draw(float elapsed_ms, bool game_active)
 	gl_has_errors();
 }
 
+GLuint RenderSystem::textureHandle(TEXTURE_ASSET_ID id) const
+{
+	return id == TEXTURE_ASSET_ID::TEXTURE_COUNT ? 0 : texture_gl_handles[(GLuint)id];
+}
+
+GLuint RenderSystem::standaloneTexture(TEXTURE_ASSET_ID id) const
+{
+	assert(id != TEXTURE_ASSET_ID::TEXTURE_COUNT);
+	assert(texture_uv_rects[(GLuint)id] == vec4(0.f, 0.f, 1.f, 1.f) && "atlased textures only draw through the sprite batch");
+	return texture_gl_handles[(GLuint)id];
+}
+
+void RenderSystem::queueSprite(const Transform &transform, GLuint texture, const vec4 &uv_rect, const vec4 &color, const mat3 &projection)
+{
+	if (texture != sprite_batch_texture)
+	{
+		flushSprites();
+		sprite_batch_texture = texture;
+	}
+	sprite_batch_projection = projection;
+
+	const mat3 &m = transform.mat;
+	sprite_batch.push_back({vec4(m[0].x, m[0].y, m[1].x, m[1].y), vec2(m[2].x, m[2].y), uv_rect, color});
+}
+
+// One instanced draw for everything queued since the last flush.
+void RenderSystem::flushSprites()
+{
+	if (sprite_batch.empty())
+		return;
+
+	const GLuint program = effects[(GLuint)EFFECT_ASSET_ID::SPRITE_INSTANCED];
+	const EffectLocations &loc = effect_locations[(GLuint)EFFECT_ASSET_ID::SPRITE_INSTANCED];
+	useProgram(program);
+	bindVertexArray(vertex_arrays[(GLuint)GEOMETRY_BUFFER_ID::SPRITE_INSTANCES]);
+	bindBuffer(GL_ARRAY_BUFFER, vertex_buffers[(GLuint)GEOMETRY_BUFFER_ID::SPRITE_INSTANCES]);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(SpriteInstance) * sprite_batch.size(), sprite_batch.data(), GL_STREAM_DRAW);
+	gl_has_errors();
+
+	activeTexture(GL_TEXTURE0);
+	bindTexture(sprite_batch_texture);
+	glUniformMatrix3fv(loc.projection, 1, GL_FALSE, (float *)&sprite_batch_projection);
+	gl_has_errors();
+
+	glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr, (GLsizei)sprite_batch.size());
+	stats.draw_calls++;
+	gl_has_errors();
+
+	sprite_batch.clear();
+}
+
+// Each helper skips the GL call when the context already has that state. Only the
+// per-frame state goes through here; see GlStateCache for what is tracked.
+void RenderSystem::useProgram(GLuint program)
+{
+	if (gl_state.program == program)
+	{
+		stats.gl_calls_skipped++;
+		return;
+	}
+	glUseProgram(program);
+	gl_state.program = program;
+	stats.program_binds++;
+	stats.gl_calls_issued++;
+}
+
+void RenderSystem::bindBuffer(GLenum target, GLuint buffer)
+{
+	// element array bindings belong to the bound VAO, so only GL_ARRAY_BUFFER is cached
+	if (target == GL_ARRAY_BUFFER && gl_state.array_buffer == buffer)
+	{
+		stats.gl_calls_skipped++;
+		return;
+	}
+	glBindBuffer(target, buffer);
+	if (target == GL_ARRAY_BUFFER)
+		gl_state.array_buffer = buffer;
+	stats.buffer_binds++;
+	stats.gl_calls_issued++;
+}
+
+void RenderSystem::bindVertexArray(GLuint vao)
+{
+	if (gl_state.vertex_array == vao)
+	{
+		stats.gl_calls_skipped++;
+		return;
+	}
+	glBindVertexArray(vao);
+	gl_state.vertex_array = vao;
+	stats.vertex_array_binds++;
+	stats.gl_calls_issued++;
+}
+
+void RenderSystem::activeTexture(GLenum unit)
+{
+	if (gl_state.active_texture == unit)
+	{
+		stats.gl_calls_skipped++;
+		return;
+	}
+	glActiveTexture(unit);
+	gl_state.active_texture = unit;
+	gl_state.texture = GlStateCache::UNKNOWN; // tracked for one unit at a time
+	stats.gl_calls_issued++;
+}
+
+void RenderSystem::bindTexture(GLuint texture)
+{
+	if (gl_state.texture == texture)
+	{
+		stats.gl_calls_skipped++;
+		return;
+	}
+	glBindTexture(GL_TEXTURE_2D, texture);
+	gl_state.texture = texture;
+	stats.texture_binds++;
+	stats.gl_calls_issued++;
+}
+
+void RenderSystem::setCapability(GLenum capability, bool enabled)
+{
+	assert(capability == GL_BLEND || capability == GL_DEPTH_TEST);
+	int &cached = capability == GL_BLEND ? gl_state.blend : gl_state.depth_test;
+	if (cached == (int)enabled)
+	{
+		stats.gl_calls_skipped++;
+		return;
+	}
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+	cached = (int)enabled;
+	stats.gl_calls_issued++;
+}
+
+void RenderSystem::setViewport(int x, int y, int width, int height)
+{
+	const ivec4 viewport = {x, y, width, height};
+	if (gl_state.viewport == viewport)
+	{
+		stats.gl_calls_skipped++;
+		return;
+	}
+	glViewport(x, y, width, height);
+	gl_state.viewport = viewport;
+	stats.gl_calls_issued++;
+}
+
 /* Note(@Davis):
  * Although we store the position of the camera, a moving camera doesn't actually "move".
  * The display technically remains static, but view of the world is being shifted.
@@ -774,13 +1001,13 @@ void RenderSystem::draw(float elapsed_ms, bool game_active)
  */
 mat3 RenderSystem::createProjectionMatrix()
 {
-	Camera camera = registry.cameras.components[0];
+	vec2 view_min, view_max;
+	getCameraBounds(view_min, view_max);
 
-	// Fixed camera view centered around player
-	float left = camera.position.x - VIEWPORT_WIDTH_PX / 2.f;
-	float right = camera.position.x + VIEWPORT_WIDTH_PX / 2.f;
-	float bottom = camera.position.y - VIEWPORT_HEIGHT_PX / 2.f;
-	float top = camera.position.y + VIEWPORT_HEIGHT_PX / 2.f;
+	float left = view_min.x;
+	float right = view_max.x;
+	float bottom = view_min.y;
+	float top = view_max.y;
 
 	// Scale factors, to scale to [-1, 1] OpenGl coordinate space
 	float sx = 2.f / (right - left);
@@ -796,6 +1023,15 @@ mat3 RenderSystem::createProjectionMatrix()
 		{tx, ty, 1.f}};
 }
 
+void RenderSystem::getCameraBounds(vec2 &view_min, vec2 &view_max)
+{
+	Camera camera = registry.cameras.components[0];
+
+	// Fixed camera view centered around player
+	view_min = camera.position - vec2(VIEWPORT_WIDTH_PX, VIEWPORT_HEIGHT_PX) / 2.f;
+	view_max = camera.position + vec2(VIEWPORT_WIDTH_PX, VIEWPORT_HEIGHT_PX) / 2.f;
+}
+
 void RenderSystem::resizeScreenTexture(int width, int height)
 {
 	// Delete the previous color texture and depth buffer
@@ -3,10 +3,93 @@
 #include <array>
 #include <utility>
 
+#include <glm/vec4.hpp>
+#include <glm/ext/vector_int4.hpp>
+
 #include "common.hpp"
+#include "level_tiles.hpp"
+#include "render_queue.hpp"
+#include "texture_atlas.hpp"
+#include "tile_map.hpp"
 #include "tinyECS/components.hpp"
 #include "tinyECS/tiny_ecs.hpp"
 
+// GL work done by one draw(), reset at the start of every frame (see render_bench.hpp).
+struct RenderStats
+{
+  int draw_calls = 0;
+  int program_binds = 0;
+  int buffer_binds = 0;
+  int texture_binds = 0;
+  int vertex_array_binds = 0;
+
+  // every state call made through the GlStateCache helpers, and how many of those it dropped
+  int gl_calls_issued = 0;
+  int gl_calls_skipped = 0;
+
+  // world-space sprites tested against the camera rect: drawn, and dropped
+  int cull_drawn = 0;
+  int cull_culled = 0;
+
+  // level art tiles drawn, and uploaded into the tile cache
+  int level_tiles_drawn = 0;
+  int level_tile_uploads = 0;
+  // tile map chunks drawn, when the level draws from its tile layer
+  int tile_chunks_drawn = 0;
+
+  int state_changes() const { return program_binds + buffer_binds + texture_binds + vertex_array_binds; }
+};
+
+// The GL state the renderer last set, so helpers like useProgram() can skip binds that
+// change nothing. UNKNOWN (or -1) means "not set this frame", which always issues the call.
+struct GlStateCache
+{
+  static constexpr GLuint UNKNOWN = ~0u;
+
+  GLuint program = UNKNOWN;
+  GLuint vertex_array = UNKNOWN;
+  GLuint array_buffer = UNKNOWN;
+  GLenum active_texture = UNKNOWN;
+  GLuint texture = UNKNOWN; // GL_TEXTURE_2D on active_texture
+  int blend = -1;
+  int depth_test = -1;
+  ivec4 viewport = ivec4(-1);
+};
+
+// Vertex attribute locations bound into every effect before linking, so one VAO per
+// geometry works with whichever effect draws it (see initializeGlGeometryBuffers).
+constexpr GLuint ATTRIB_POSITION = 0;
+constexpr GLuint ATTRIB_TEXCOORD = 1;
+constexpr GLuint ATTRIB_COLOR = 2;
+
+// Uniform locations of one effect, looked up once by initializeGlEffects so
+// drawing never has to ask the driver. -1 when the shader doesn't use the name.
+struct EffectLocations
+{
+  GLint transform = -1;
+  GLint projection = -1;
+  GLint fcolor = -1;
+  GLint translucent_alpha = -1;
+  GLint fireball_alpha = -1;
+  GLint camera_pos = -1;
+  GLint parallax_factor = -1;
+  GLint texture_size = -1;
+  GLint flip_texture_x = -1; // u_flipTextureX
+  GLint time = -1;
+  GLint darken_screen_factor = -1;
+  GLint apply_vignette = -1;
+  GLint apply_fadeout = -1;
+};
+
+// Per-instance data for one batched sprite, laid out as the attributes of shaders/sprite.vs.glsl.
+struct SpriteInstance
+{
+  vec4 transform_linear;      // columns 0 and 1 of the 2D transform
+  vec2 transform_translation; // column 2
+  vec4 uv_rect;               // u0, v0, u1, v1 (u0 > u1 mirrors the sprite)
+  vec4 color;                 // fcolor and the effect's alpha
+};
+
 // System responsible for setting up OpenGL and for rendering all the
 // visual entities in the game
 class RenderSystem
@@ -18,8 +101,22 @@ class RenderSystem
    * Whenever possible, add to these lists instead of creating dynamic state
    * it is easier to debug and faster to execute for the computer.
    */
-  std::array<GLuint, texture_count> texture_gl_handles;
+  std::array<GLuint, texture_count> texture_gl_handles; // atlased textures hold their page
   std::array<ivec2, texture_count> texture_dimensions;
+  std::array<vec4, texture_count> texture_uv_rects; // {u0, v0, u1, v1} on the texture above
+  std::vector<GLuint> atlas_pages;
+
+  // small images share atlas pages (see initializeGlTextures)
+  static constexpr int ATLAS_PAGE_SIZE = 4096;
+  static constexpr int ATLAS_MAX_IMAGE_SIZE = 512;
+  static constexpr int ATLAS_PADDING = 1;
+
+  // level art is streamed by LevelTileCache from its tile files (LEVEL_ART in CMakeLists.txt),
+  // never loaded here
+  static bool isStreamedTexture(TEXTURE_ASSET_ID id) { return id >= TEXTURE_ASSET_ID::LEVEL_1 && id <= TEXTURE_ASSET_ID::LEVEL_TUNNEL; }
+  static constexpr int LEVEL_TILE_CACHE_MB = 48;
+  static constexpr float LEVEL_TILE_PREFETCH_PX = 256.f;
+  static constexpr int LEVEL_TILE_PREFETCH_UPLOADS = 2; // per frame
 
   // Make sure these paths remain in sync with the associated enumerators.
   // Associated id with .obj path
@@ -154,6 +251,7 @@ class RenderSystem
       textures_path("levels/under.png"),
       textures_path("levels/snake.png"),
       textures_path("levels/tunnelsmall.png"),
+      textures_path("levels/tunnel.png"),
 
       // Parallax
       textures_path("levels/background_0.png"),
@@ -251,6 +349,7 @@ class RenderSystem
   };
 
   std::array<GLuint, effect_count> effects;
+  std::array<EffectLocations, effect_count> effect_locations;
   // Make sure these paths remain in sync with the associated enumerators.
   const std::array<std::string, effect_count> effect_paths = {
       shader_path("egg"),
@@ -261,10 +360,13 @@ class RenderSystem
       shader_path("translucent"),
       shader_path("fireball"),
       shader_path("player"),
+      shader_path("sprite"),
   };
 
   std::array<GLuint, geometry_count> vertex_buffers;
   std::array<GLuint, geometry_count> index_buffers;
+  std::array<GLsizei, geometry_count> index_counts = {}; // set by bindVBOandIBO
+  std::array<GLuint, geometry_count> vertex_arrays;         // buffers + attribute layout of each geometry
   std::array<Mesh, geometry_count> meshes;
 
 public:
@@ -284,6 +386,10 @@ public:
 
   void initializeGlGeometryBuffers();
 
+  // Builds the VAO of each geometry once its buffers are filled
+  void initializeGlVertexArrays();
+  void initSpriteInstanceLayout(GLuint instance_buffer);
+
   // Initialize the screen texture used as intermediate render target
   // The draw loop first renders to this texture, then it is used for the vignette shader
   bool initScreenTexture();
@@ -295,22 +401,99 @@ public:
   void draw(float elapsed_ms, bool game_active);
 
   mat3 createProjectionMatrix();
+  // world-space rect the projection above shows
+  void getCameraBounds(vec2 &view_min, vec2 &view_max);
 
   Entity get_screen_state_entity() { return screen_state_entity; }
 
   // Window resizing
   void resizeScreenTexture(int width, int height);
 
+  // Prepare the art of the level that was just loaded (tile map, or the level's tile files).
+  // Call once per level start: draw() only decodes the level tiles it uploads.
+  void loadLevelArt(TEXTURE_ASSET_ID level_texture);
+
   int screen_viewport_x = 0, screen_viewport_y = 0;
   int screen_viewport_w = 1200, screen_viewport_h = 900;
 
+  // counters for the last draw()
+  RenderStats stats;
+
+  // Debug builds only, set before init(): make KHR_debug output synchronous and keep
+  // polling glGetError after every call, so a failing call is reported where it happens.
+  bool synchronous_gl_checks = false;
+
 private:
+  // Debug builds: route driver messages through KHR_debug when the context supports it
+  void initDebugOutput();
+
+  // state changes go through these so they show up in stats, and repeats are skipped
+  void useProgram(GLuint program);
+  void bindBuffer(GLenum target, GLuint buffer);
+  void bindVertexArray(GLuint vao);
+  void activeTexture(GLenum unit);
+  void bindTexture(GLuint texture);
+  void setCapability(GLenum capability, bool enabled); // GL_BLEND or GL_DEPTH_TEST
+  void setViewport(int x, int y, int width, int height);
+  GlStateCache gl_state;
+
+  // GL texture an id draws from (its atlas page if atlased), 0 for TEXTURE_COUNT
+  GLuint textureHandle(TEXTURE_ASSET_ID id) const;
+  // for shaders that sample the whole [0, 1] range, which an atlased image doesn't own
+  GLuint standaloneTexture(TEXTURE_ASSET_ID id) const;
+
+  // kept across frames so submitting doesn't allocate
+  RenderQueue render_queue;
+  // non-looping animations that played out this frame
+  std::vector<Entity> finished_animations;
+
+  // the current level's art, resident near the camera only
+  LevelTileCache level_tiles;
+  GLuint level_tile_texture = 0;
+  TEXTURE_ASSET_ID level_tiles_source = TEXTURE_ASSET_ID::TEXTURE_COUNT;
+  std::vector<LevelTileCache::Tile> level_tiles_visible;
+  std::vector<LevelTileCache::Upload> level_tile_uploads;
+  std::vector<uint8_t> level_tile_pixels;
+
+  // the current level's tile layer, when its tilesets are on disk: static instance buffers
+  // per TILE_CHUNK_TILES square of tiles, drawn with the sprite shader from one atlas page
+  struct TileChunk
+  {
+    vec2 world_min, world_max;
+    GLuint vertex_array = 0;
+    GLuint instance_buffer = 0;
+    GLsizei instance_count = 0;
+  };
+  static constexpr int TILE_CHUNK_TILES = 16;
+  std::vector<TileChunk> tile_chunks;
+  GLuint tile_map_texture = 0;
+  unsigned int tile_map_version = ~0u; // level_tile_layer_version the chunks were built for
+  bool tile_map_ready = false;
+  bool buildTileMap(vec2 world_min, vec2 world_per_px);
+  void clearTileMap();
+  void drawTileMap(const mat3 &projection);
+
   // Internal drawing functions for each entity type
   void drawGridLine(Entity entity, const mat3 &projection);
   void drawLine(Entity entity, const mat3 &projection);
+  void drawLevelTiles(Entity entity, const mat3 &projection);
+  void drawRope(Entity entity, const mat3 &projection);
+  void drawTrajectoryArc(Entity entity, const mat3 &projection);
+  void drawPolyline(const float *xs, const float *ys, size_t count, float thickness, const vec3 &color, const mat3 &projection);
+  bool advanceAnimation(RenderRequest &render_request, float elapsed_ms);
   void drawTexturedMesh(Entity entity, const mat3 &projection, float elapsed_ms, bool game_active);
   void drawToScreen();
 
+  // Sprite batching: SPRITE geometry drawn with a textured effect is queued by
+  // drawTexturedMesh() and drawn as one instanced call per run of the same texture.
+  // Every other draw flushes first, so layering is the same as drawing one by one.
+  void queueSprite(const Transform &transform, GLuint texture, const vec4 &uv_rect, const vec4 &color, const mat3 &projection);
+  void flushSprites();
+
+  std::vector<SpriteInstance> sprite_batch;
+  GLuint sprite_batch_texture = 0;
+  mat3 sprite_batch_projection;
+
   // Window handle
   GLFWwindow *window;
 
@@ -324,3 +507,10 @@ private:
 
 bool loadEffectFromFile(
     const std::string &vs_path, const std::string &fs_path, GLuint &out_program);
+
+// Debug label for a GL object (GL_TEXTURE, GL_PROGRAM, ...), when KHR_debug is active
+#ifdef NDEBUG
+inline void gl_label_object(GLenum identifier, GLuint name, const std::string &label) {}
+#else
+void gl_label_object(GLenum identifier, GLuint name, const std::string &label);
+#endif
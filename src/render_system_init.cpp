@@ -3,6 +3,10 @@
 #include <sstream>
 #include <array>
 #include <fstream>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
 
 // internal
 #include "../ext/stb_image/stb_image.h"
@@ -39,17 +43,15 @@ bool RenderSystem::init(GLFWwindow* window_arg)
 		printf("requested window width,height = %d,%d\n", WINDOW_WIDTH_PX, WINDOW_HEIGHT_PX);
 	}
 
-	// Hint: Ask your TA for how to setup pretty OpenGL error callbacks. 
-	// This can not be done in mac os, so do not enable
-	// it unless you are on Linux or Windows. You will need to change the window creation
-	// code to use OpenGL 4.3 (not suported on mac) and add additional .h and .cpp
-	// glDebugMessageCallback((GLDEBUGPROC)errorCallback, nullptr);
-
-	// We are not really using VAO's but without at least one bound we will crash in
-	// some systems.
-	GLuint vao;
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+#ifndef NDEBUG
+	// Driver error callbacks, where available (not on macOS, which has no KHR_debug)
+	initDebugOutput();
+#endif
+
+	// One VAO per geometry, filled in by initializeGlVertexArrays. Bind one right away,
+	// without at least one bound we will crash in some systems.
+	glGenVertexArrays((GLsizei)vertex_arrays.size(), vertex_arrays.data());
+	glBindVertexArray(vertex_arrays[0]);
 	gl_has_errors();
 
 	initScreenTexture();
@@ -60,32 +62,102 @@ bool RenderSystem::init(GLFWwindow* window_arg)
 	return true;
 }
 
+static stbi_uc* load_texture_file(const std::string& path, ivec2& dimensions)
+{
+	stbi_uc* data = stbi_load(path.c_str(), &dimensions.x, &dimensions.y, NULL, 4);
+	if (data == NULL)
+	{
+		const std::string message = "Could not load the file " + path + ".";
+		fprintf(stderr, "%s", message.c_str());
+		assert(false);
+	}
+	return data;
+}
+
+static void upload_texture(GLuint texture, const std::string& label, ivec2 dimensions, const void* data)
+{
+	glBindTexture(GL_TEXTURE_2D, texture);
+	gl_label_object(GL_TEXTURE, texture, label);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, dimensions.x, dimensions.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	gl_has_errors();
+}
+
+// Images no bigger than ATLAS_MAX_IMAGE_SIZE (digits, buttons, HUD, animation frames) are
+// packed into shared pages, so sprites using any of them batch into one draw. Only their
+// headers are read to pack; each page is then decoded into and uploaded before the next,
+// so at most one page is held in memory. Level art is streamed in tiles instead (see
+// LevelTileCache), and everything else gets a texture of its own.
 void RenderSystem::initializeGlTextures()
 {
-    glGenTextures((GLsizei)texture_gl_handles.size(), texture_gl_handles.data());
+	stbi_set_flip_vertically_on_load(true);
 
-    stbi_set_flip_vertically_on_load(true);
-    for(uint i = 0; i < texture_paths.size(); i++)
-    {
-		const std::string& path = texture_paths[i];
+	std::vector<uint> atlased;
+	std::vector<ivec2> atlased_sizes;
+	for(uint i = 0; i < texture_paths.size(); i++)
+	{
 		ivec2& dimensions = texture_dimensions[i];
+		texture_uv_rects[i] = {0.f, 0.f, 1.f, 1.f};
+		if (isStreamedTexture((TEXTURE_ASSET_ID)i))
+		{
+			texture_gl_handles[i] = 0;
+			stbi_info(texture_paths[i].c_str(), &dimensions.x, &dimensions.y, NULL);
+			continue;
+		}
+		if (stbi_info(texture_paths[i].c_str(), &dimensions.x, &dimensions.y, NULL) &&
+			dimensions.x <= ATLAS_MAX_IMAGE_SIZE && dimensions.y <= ATLAS_MAX_IMAGE_SIZE)
+		{
+			atlased.push_back(i);
+			atlased_sizes.push_back(dimensions);
+			continue;
+		}
+
+		stbi_uc* data = load_texture_file(texture_paths[i], dimensions);
+		glGenTextures(1, &texture_gl_handles[i]);
+		upload_texture(texture_gl_handles[i], texture_paths[i], dimensions, data);
+		stbi_image_free(data);
+	}
+
+	GLint max_texture_size = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+
+	// level tile cache: as many slots as fit the budget, filled as the camera moves
+	const int slot_bytes = LevelTileCache::SLOT_SIZE * LevelTileCache::SLOT_SIZE * 4;
+	int slots_per_side = (int)std::sqrt((double)LEVEL_TILE_CACHE_MB * 1024 * 1024 / slot_bytes);
+	slots_per_side = std::min(slots_per_side, (int)max_texture_size / LevelTileCache::SLOT_SIZE);
+	level_tiles.set_capacity(slots_per_side);
+	glGenTextures(1, &level_tile_texture);
+	upload_texture(level_tile_texture, "level tile cache", ivec2(level_tiles.cache_texture_size()), nullptr);
 
-		stbi_uc* data;
-		data = stbi_load(path.c_str(), &dimensions.x, &dimensions.y, NULL, 4);
+	const int page_size = std::min(ATLAS_PAGE_SIZE, (int)max_texture_size);
+	const AtlasLayout layout = pack_texture_atlas(atlased_sizes, page_size, ATLAS_PADDING);
 
-		if (data == NULL)
+	atlas_pages.resize(layout.page_extents.size());
+	glGenTextures((GLsizei)atlas_pages.size(), atlas_pages.data());
+	std::vector<uint8_t> pixels;
+	for (size_t page = 0; page < atlas_pages.size(); page++)
+	{
+		const ivec2 extent = layout.page_extents[page];
+		pixels.assign((size_t)extent.x * extent.y * 4, 0);
+
+		for (size_t j = 0; j < atlased.size(); j++)
 		{
-			const std::string message = "Could not load the file " + path + ".";
-			fprintf(stderr, "%s", message.c_str());
-			assert(false);
+			const AtlasPlacement& placement = layout.placements[j];
+			if (placement.page != (int)page)
+				continue;
+
+			const uint i = atlased[j];
+			stbi_uc* data = load_texture_file(texture_paths[i], texture_dimensions[i]);
+			blit_into_atlas_page(pixels.data(), extent.x, placement.position, data, texture_dimensions[i], ATLAS_PADDING);
+			stbi_image_free(data);
+
+			texture_gl_handles[i] = atlas_pages[page];
+			texture_uv_rects[i] = atlas_uv_rect(placement, texture_dimensions[i], extent);
 		}
-		glBindTexture(GL_TEXTURE_2D, texture_gl_handles[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, dimensions.x, dimensions.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		gl_has_errors();
-		stbi_image_free(data);
-    }
+
+		upload_texture(atlas_pages[page], "atlas page " + std::to_string(page), extent, pixels.data());
+	}
 	gl_has_errors();
 }
 
@@ -98,6 +170,25 @@ void RenderSystem::initializeGlEffects()
 
 		bool is_valid = loadEffectFromFile(vertex_shader_name, fragment_shader_name, effects[i]);
 		assert(is_valid && (GLuint)effects[i] != 0);
+		gl_label_object(GL_PROGRAM, effects[i], effect_paths[i]);
+
+		// reflect every name the draw functions use, so they never query the driver
+		const GLuint program = effects[i];
+		EffectLocations& loc = effect_locations[i];
+		loc.transform = glGetUniformLocation(program, "transform");
+		loc.projection = glGetUniformLocation(program, "projection");
+		loc.fcolor = glGetUniformLocation(program, "fcolor");
+		loc.translucent_alpha = glGetUniformLocation(program, "translucent_alpha");
+		loc.fireball_alpha = glGetUniformLocation(program, "fireball_alpha");
+		loc.camera_pos = glGetUniformLocation(program, "camera_pos");
+		loc.parallax_factor = glGetUniformLocation(program, "parallax_factor");
+		loc.texture_size = glGetUniformLocation(program, "texture_size");
+		loc.flip_texture_x = glGetUniformLocation(program, "u_flipTextureX");
+		loc.time = glGetUniformLocation(program, "time");
+		loc.darken_screen_factor = glGetUniformLocation(program, "darken_screen_factor");
+		loc.apply_vignette = glGetUniformLocation(program, "apply_vignette");
+		loc.apply_fadeout = glGetUniformLocation(program, "apply_fadeout");
+		gl_has_errors();
 	}
 }
 
@@ -114,6 +205,8 @@ void RenderSystem::bindVBOandIBO(GEOMETRY_BUFFER_ID gid, std::vector<T> vertices
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
 		sizeof(indices[0]) * indices.size(), indices.data(), GL_STATIC_DRAW);
 	gl_has_errors();
+
+	index_counts[(uint)gid] = (GLsizei)indices.size();
 }
 
 void RenderSystem::initializeGlMeshes()
@@ -223,6 +316,86 @@ void RenderSystem::initializeGlGeometryBuffers()
 	// Counterclockwise as it's the default opengl front winding direction.
 	const std::vector<uint16_t> screen_indices = { 0, 1, 2 };
 	bindVBOandIBO(GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE, screen_vertices, screen_indices);
+
+	initializeGlVertexArrays();
+	sprite_batch.reserve(256);
+}
+
+// Attribute pointers are VAO state, so each geometry's layout is specified once here and
+// a draw only binds the VAO. Locations are the fixed ATTRIB_* ones bound in loadEffectFromFile.
+void RenderSystem::initializeGlVertexArrays()
+{
+	auto textured_layout = [](GLuint vbo) {
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glEnableVertexAttribArray(ATTRIB_POSITION);
+		glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*)0);
+		glEnableVertexAttribArray(ATTRIB_TEXCOORD);
+		glVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*)sizeof(vec3));
+	};
+	auto colored_layout = [](GLuint vbo) {
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glEnableVertexAttribArray(ATTRIB_POSITION);
+		glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*)0);
+		glEnableVertexAttribArray(ATTRIB_COLOR);
+		glVertexAttribPointer(ATTRIB_COLOR, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*)sizeof(vec3));
+	};
+
+	for (uint i = 0; i < geometry_count; i++)
+	{
+		const GEOMETRY_BUFFER_ID gid = (GEOMETRY_BUFFER_ID)i;
+		glBindVertexArray(vertex_arrays[i]);
+
+		switch (gid)
+		{
+		case GEOMETRY_BUFFER_ID::SPRITE:
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers[i]);
+			textured_layout(vertex_buffers[i]);
+			break;
+		case GEOMETRY_BUFFER_ID::LEGACY_CHICKEN:
+		case GEOMETRY_BUFFER_ID::LEGACY_EGG:
+		case GEOMETRY_BUFFER_ID::DEBUG_LINE:
+		case GEOMETRY_BUFFER_ID::ROPE_STRIP: // drawn with glDrawArrays, no indices
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers[i]);
+			colored_layout(vertex_buffers[i]);
+			break;
+		case GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE:
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers[i]);
+			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[i]);
+			glEnableVertexAttribArray(ATTRIB_POSITION);
+			glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
+			break;
+		case GEOMETRY_BUFFER_ID::SPRITE_INSTANCES:
+			// the SPRITE quad per vertex, plus one SpriteInstance per instance
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers[(GLuint)GEOMETRY_BUFFER_ID::SPRITE]);
+			textured_layout(vertex_buffers[(GLuint)GEOMETRY_BUFFER_ID::SPRITE]);
+			initSpriteInstanceLayout(vertex_buffers[(GLuint)GEOMETRY_BUFFER_ID::SPRITE_INSTANCES]);
+			break;
+		default:
+			assert(false && "Geometry without a vertex layout");
+		}
+		gl_has_errors();
+	}
+
+	glBindVertexArray(vertex_arrays[0]);
+}
+
+// Instance attributes of shaders/sprite.vs.glsl, read from instance_buffer once per instance
+// (SPRITE_INSTANCES for the sprite batch, or a tile map chunk).
+void RenderSystem::initSpriteInstanceLayout(GLuint instance_buffer)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+	const GLsizei stride = sizeof(SpriteInstance);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SpriteInstance, transform_linear));
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SpriteInstance, transform_translation));
+	glEnableVertexAttribArray(4);
+	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SpriteInstance, uv_rect));
+	glEnableVertexAttribArray(5);
+	glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SpriteInstance, color));
+	for (GLuint loc = 2; loc <= 5; loc++)
+		glVertexAttribDivisor(loc, 1);
+	gl_has_errors();
 }
 
 RenderSystem::~RenderSystem()
@@ -231,9 +404,13 @@ RenderSystem::~RenderSystem()
 	// but it's polite to clean after yourself.
 	glDeleteBuffers((GLsizei)vertex_buffers.size(), vertex_buffers.data());
 	glDeleteBuffers((GLsizei)index_buffers.size(), index_buffers.data());
+	// atlased textures share their page's name, deleting it more than once is harmless
 	glDeleteTextures((GLsizei)texture_gl_handles.size(), texture_gl_handles.data());
+	glDeleteTextures(1, &level_tile_texture);
+	clearTileMap();
 	glDeleteTextures(1, &off_screen_render_buffer_color);
 	glDeleteRenderbuffers(1, &off_screen_render_buffer_depth);
+	glDeleteVertexArrays((GLsizei)vertex_arrays.size(), vertex_arrays.data());
 	gl_has_errors();
 
 	for(uint i = 0; i < effect_count; i++) {
@@ -347,6 +524,10 @@ bool loadEffectFromFile(
 	out_program = glCreateProgram();
 	glAttachShader(out_program, vertex);
 	glAttachShader(out_program, fragment);
+	// same locations in every effect so the geometry VAOs fit all of them
+	glBindAttribLocation(out_program, ATTRIB_POSITION, "in_position");
+	glBindAttribLocation(out_program, ATTRIB_TEXCOORD, "in_texcoord");
+	glBindAttribLocation(out_program, ATTRIB_COLOR, "in_color");
 	glLinkProgram(out_program);
 	gl_has_errors();
 
@@ -378,3 +559,113 @@ bool loadEffectFromFile(
 	return true;
 }
 
+#ifndef NDEBUG
+// Set by initDebugOutput. While the KHR_debug callback is reporting errors there is no need
+// to poll glGetError, unless synchronous checks were asked for.
+static bool gl_debug_output_active = false;
+static bool gl_poll_errors = true;
+
+static void APIENTRY gl_debug_callback(GLenum source, GLenum type, GLuint id, GLenum severity,
+	GLsizei length, const GLchar* message, const void* user_param)
+{
+	const char* severity_str = "LOW";
+	switch (severity)
+	{
+	case GL_DEBUG_SEVERITY_HIGH:
+		severity_str = "HIGH";
+		break;
+	case GL_DEBUG_SEVERITY_MEDIUM:
+		severity_str = "MEDIUM";
+		break;
+	}
+	fprintf(stderr, "OpenGL [%s%s, id %u]: %.*s\n",
+		type == GL_DEBUG_TYPE_ERROR ? "ERROR, " : "", severity_str, id, (int)length, message);
+
+	// only meaningful when the message arrives on the call that caused it
+	const bool synchronous = *(const bool*)user_param;
+	if (synchronous && type == GL_DEBUG_TYPE_ERROR)
+		assert(false);
+}
+
+static bool gl_has_extension(const char* name)
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; i++)
+	{
+		if (strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), name) == 0)
+			return true;
+	}
+	return false;
+}
+
+void RenderSystem::initDebugOutput()
+{
+	GLint flags = 0;
+	glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+	if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT) || !gl_has_extension("GL_KHR_debug") || !glDebugMessageCallback)
+	{
+		printf("GL_KHR_debug not available, falling back to glGetError checks\n");
+		return;
+	}
+
+	glEnable(GL_DEBUG_OUTPUT);
+	if (synchronous_gl_checks)
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	glDebugMessageCallback(gl_debug_callback, &synchronous_gl_checks);
+
+	// drop the driver's chatter (buffer placement, shader recompiles...), keep medium and high
+	// severity; low severity only while chasing a bug with --gl-sync
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_LOW, 0, nullptr, synchronous_gl_checks ? GL_TRUE : GL_FALSE);
+
+	gl_debug_output_active = true;
+	gl_poll_errors = synchronous_gl_checks;
+}
+
+// Names show up in driver messages and in frame debuggers such as RenderDoc
+void gl_label_object(GLenum identifier, GLuint name, const std::string& label)
+{
+	if (gl_debug_output_active)
+		glObjectLabel(identifier, name, (GLsizei)label.size(), label.c_str());
+}
+
+// lives with the renderer so the GL-free simulation sources (common.cpp included) don't link against GL
+bool gl_has_errors()
+{
+	if (!gl_poll_errors) return false;
+
+	GLenum error = glGetError();
+
+	if (error == GL_NO_ERROR) return false;
+
+	while (error != GL_NO_ERROR)
+	{
+		const char* error_str = "";
+		switch (error)
+		{
+		case GL_INVALID_OPERATION:
+			error_str = "INVALID_OPERATION";
+			break;
+		case GL_INVALID_ENUM:
+			error_str = "INVALID_ENUM";
+			break;
+		case GL_INVALID_VALUE:
+			error_str = "INVALID_VALUE";
+			break;
+		case GL_OUT_OF_MEMORY:
+			error_str = "OUT_OF_MEMORY";
+			break;
+		case GL_INVALID_FRAMEBUFFER_OPERATION:
+			error_str = "INVALID_FRAMEBUFFER_OPERATION";
+			break;
+		}
+
+		fprintf(stderr, "OpenGL: %s", error_str);
+		error = glGetError();
+		assert(false);
+	}
+
+	return true;
+}
+#endif
@@ -0,0 +1,224 @@
+// stdlib
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+
+// internal
+#include "../ext/stb_image/stb_image.h"
+#include "render_system.hpp"
+
+// A tileset image decoded once, however many tiles are cut from it
+struct TilesetImage
+{
+	std::unique_ptr<stbi_uc, void (*)(void *)> pixels{nullptr, stbi_image_free};
+	ivec2 size = ivec2(0);
+};
+
+// Tiled flips, in the y-up frame of the sprite quad: the diagonal flip swaps the axes of the
+// y-down image, which is the anti-diagonal here, and it applies before the other two.
+static mat2 tile_flip(uint32_t gid)
+{
+	mat2 flip = mat2(1.f);
+	if (gid & TILE_FLIPPED_DIAGONALLY)
+		flip = mat2(0.f, -1.f, -1.f, 0.f);
+	if (gid & TILE_FLIPPED_HORIZONTALLY)
+		flip = mat2(-1.f, 0.f, 0.f, 1.f) * flip;
+	if (gid & TILE_FLIPPED_VERTICALLY)
+		flip = mat2(1.f, 0.f, 0.f, -1.f) * flip;
+	return flip;
+}
+
+// Builds the chunks for level_tile_layer. The tiles the level uses are cut out of their
+// tilesets and packed into a single atlas page; each chunk is one static instance buffer.
+// Returns false, with nothing built, if a tileset or image is missing or the tiles don't fit
+// a page: the level png is drawn instead.
+bool RenderSystem::buildTileMap(vec2 world_min, vec2 world_per_px)
+{
+	clearTileMap();
+	const TileLayer &layer = level_tile_layer;
+	if (layer.gids.empty())
+		return false;
+
+	std::unordered_map<uint32_t, TilesetTile> tileset_tiles;
+	for (const TilesetRef &tileset : layer.tilesets)
+	{
+		if (!load_tileset(LEVEL_DIR_FILEPATH + tileset.source, tileset.first_gid, tileset_tiles))
+			return false;
+	}
+
+	// the tiles in use, in a fixed order for packing
+	std::vector<uint32_t> used;
+	std::unordered_map<uint32_t, size_t> used_index;
+	for (uint32_t gid : layer.gids)
+	{
+		gid &= TILE_GID_MASK;
+		if (gid == 0 || used_index.count(gid))
+			continue;
+		if (!tileset_tiles.count(gid))
+		{
+			std::cerr << "Tile " << gid << " is in no tileset, drawing the level image instead" << std::endl;
+			return false;
+		}
+		used_index[gid] = used.size();
+		used.push_back(gid);
+	}
+
+	std::vector<ivec2> sizes;
+	for (uint32_t gid : used)
+		sizes.push_back(tileset_tiles[gid].size);
+	GLint max_texture_size = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+	const AtlasLayout layout = pack_texture_atlas(sizes, std::min(ATLAS_PAGE_SIZE, (int)max_texture_size), ATLAS_PADDING);
+	if (layout.page_extents.size() > 1)
+	{
+		std::cerr << "Tiles of this level don't fit one atlas page, drawing the level image instead" << std::endl;
+		return false;
+	}
+
+	// cut every tile out of its image (rows come bottom up) into the page
+	const ivec2 extent = layout.page_extents.empty() ? ivec2(1) : layout.page_extents[0];
+	std::vector<uint8_t> page((size_t)extent.x * extent.y * 4, 0);
+	std::unordered_map<std::string, TilesetImage> images;
+	std::vector<uint8_t> tile_pixels;
+	std::vector<vec4> uv_rects(used.size());
+	for (size_t i = 0; i < used.size(); i++)
+	{
+		const TilesetTile &tile = tileset_tiles[used[i]];
+		TilesetImage &image = images[tile.image];
+		if (!image.pixels)
+		{
+			image.pixels.reset(stbi_load(tile.image.c_str(), &image.size.x, &image.size.y, NULL, 4));
+			if (!image.pixels)
+			{
+				std::cerr << "Could not load the file " << tile.image << ", drawing the level image instead" << std::endl;
+				return false;
+			}
+		}
+		if (tile.origin.x + tile.size.x > image.size.x || tile.origin.y + tile.size.y > image.size.y)
+			return false;
+
+		tile_pixels.resize((size_t)tile.size.x * tile.size.y * 4);
+		const int bottom_row = image.size.y - (tile.origin.y + tile.size.y);
+		for (int y = 0; y < tile.size.y; y++)
+		{
+			const stbi_uc *src = image.pixels.get() + ((size_t)(bottom_row + y) * image.size.x + tile.origin.x) * 4;
+			std::memcpy(tile_pixels.data() + (size_t)y * tile.size.x * 4, src, (size_t)tile.size.x * 4);
+		}
+		blit_into_atlas_page(page.data(), extent.x, layout.placements[i].position, tile_pixels.data(), tile.size, ATLAS_PADDING);
+		uv_rects[i] = atlas_uv_rect(layout.placements[i], tile.size, extent);
+	}
+
+	glGenTextures(1, &tile_map_texture);
+	glBindTexture(GL_TEXTURE_2D, tile_map_texture);
+	gl_label_object(GL_TEXTURE, tile_map_texture, "tile map atlas");
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, extent.x, extent.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, page.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	gl_has_errors();
+
+	// Tiled counts rows from the top and draws a tile from the bottom left of its cell, so tiles
+	// bigger than the grid reach up and right
+	const ivec2 chunk_count = (layer.size + TILE_CHUNK_TILES - 1) / TILE_CHUNK_TILES;
+	std::vector<SpriteInstance> instances;
+	for (int chunk_y = 0; chunk_y < chunk_count.y; chunk_y++)
+	{
+		for (int chunk_x = 0; chunk_x < chunk_count.x; chunk_x++)
+		{
+			instances.clear();
+			vec2 bounds_min = vec2(INFINITY), bounds_max = vec2(-INFINITY);
+			for (int row = chunk_y * TILE_CHUNK_TILES; row < std::min((chunk_y + 1) * TILE_CHUNK_TILES, layer.size.y); row++)
+			{
+				for (int col = chunk_x * TILE_CHUNK_TILES; col < std::min((chunk_x + 1) * TILE_CHUNK_TILES, layer.size.x); col++)
+				{
+					const uint32_t gid = layer.gids[(size_t)row * layer.size.x + col];
+					if ((gid & TILE_GID_MASK) == 0)
+						continue;
+
+					const size_t index = used_index[gid & TILE_GID_MASK];
+					const vec2 size = vec2(sizes[index]) * world_per_px;
+					const vec2 cell_bottom_left = world_min + vec2(col, layer.size.y - 1 - row) * vec2(layer.tile_size) * world_per_px;
+					const vec2 center = cell_bottom_left + size / 2.f;
+					const mat2 linear = tile_flip(gid) * mat2(size.x, 0.f, 0.f, size.y);
+
+					instances.push_back({vec4(linear[0].x, linear[0].y, linear[1].x, linear[1].y), center, uv_rects[index], vec4(1.f)});
+					bounds_min = glm::min(bounds_min, cell_bottom_left);
+					bounds_max = glm::max(bounds_max, cell_bottom_left + size);
+				}
+			}
+			if (instances.empty())
+				continue;
+
+			TileChunk chunk;
+			chunk.world_min = bounds_min;
+			chunk.world_max = bounds_max;
+			chunk.instance_count = (GLsizei)instances.size();
+			glGenBuffers(1, &chunk.instance_buffer);
+			glGenVertexArrays(1, &chunk.vertex_array);
+			glBindVertexArray(chunk.vertex_array);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers[(GLuint)GEOMETRY_BUFFER_ID::SPRITE]);
+			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[(GLuint)GEOMETRY_BUFFER_ID::SPRITE]);
+			glEnableVertexAttribArray(ATTRIB_POSITION);
+			glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void *)0);
+			glEnableVertexAttribArray(ATTRIB_TEXCOORD);
+			glVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void *)sizeof(vec3));
+			glBindBuffer(GL_ARRAY_BUFFER, chunk.instance_buffer);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(SpriteInstance) * instances.size(), instances.data(), GL_STATIC_DRAW);
+			initSpriteInstanceLayout(chunk.instance_buffer);
+			gl_has_errors();
+			tile_chunks.push_back(chunk);
+		}
+	}
+
+	// the binds above went around the state cache
+	gl_state = GlStateCache();
+
+	size_t tile_count = 0;
+	for (const TileChunk &chunk : tile_chunks)
+		tile_count += chunk.instance_count;
+	std::cout << "Tile map: " << tile_count << " tiles in " << tile_chunks.size() << " chunks, "
+			  << used.size() << " distinct on a " << extent.x << "x" << extent.y << " atlas" << std::endl;
+	return true;
+}
+
+void RenderSystem::clearTileMap()
+{
+	for (const TileChunk &chunk : tile_chunks)
+	{
+		glDeleteVertexArrays(1, &chunk.vertex_array);
+		glDeleteBuffers(1, &chunk.instance_buffer);
+	}
+	tile_chunks.clear();
+	glDeleteTextures(1, &tile_map_texture);
+	tile_map_texture = 0;
+}
+
+// One instanced draw per chunk that overlaps the camera
+void RenderSystem::drawTileMap(const mat3 &projection)
+{
+	flushSprites();
+
+	const EffectLocations &loc = effect_locations[(GLuint)EFFECT_ASSET_ID::SPRITE_INSTANCED];
+	useProgram(effects[(GLuint)EFFECT_ASSET_ID::SPRITE_INSTANCED]);
+	activeTexture(GL_TEXTURE0);
+	bindTexture(tile_map_texture);
+	glUniformMatrix3fv(loc.projection, 1, GL_FALSE, (float *)&projection);
+	gl_has_errors();
+
+	vec2 view_min, view_max;
+	getCameraBounds(view_min, view_max);
+	for (const TileChunk &chunk : tile_chunks)
+	{
+		if (chunk.world_max.x < view_min.x || chunk.world_min.x > view_max.x ||
+			chunk.world_max.y < view_min.y || chunk.world_min.y > view_max.y)
+			continue;
+
+		bindVertexArray(chunk.vertex_array);
+		glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr, chunk.instance_count);
+		stats.draw_calls++;
+		stats.tile_chunks_drawn++;
+		gl_has_errors();
+	}
+}
@@ -0,0 +1,38 @@
+#include "rng.hpp"
+
+#include <random>
+
+static uint64_t current_seed = 0;
+static std::mt19937 streams[(int)RNG_STREAM::STREAM_COUNT];
+
+void rng_seed(uint64_t seed)
+{
+	current_seed = seed;
+	for (int i = 0; i < (int)RNG_STREAM::STREAM_COUNT; i++) {
+		std::seed_seq sequence{ (uint32_t)seed, (uint32_t)(seed >> 32), (uint32_t)i };
+		streams[i].seed(sequence);
+	}
+}
+
+uint64_t rng_current_seed()
+{
+	return current_seed;
+}
+
+uint64_t rng_entropy_seed()
+{
+	std::random_device device;
+	return ((uint64_t)device() << 32) | device();
+}
+
+int rng_int(RNG_STREAM stream, int lo, int hi)
+{
+	std::uniform_int_distribution<int> distribution(lo, hi);
+	return distribution(streams[(int)stream]);
+}
+
+float rng_uniform(RNG_STREAM stream)
+{
+	std::uniform_real_distribution<float> distribution(0.f, 1.f);
+	return distribution(streams[(int)stream]);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+// Seeded random numbers for the whole game. Every draw goes through one of these streams
+// instead of a local std::random_device, so a run can be reproduced from its seed
+// (see input_log.hpp). Gameplay and cosmetic draws use separate streams: cosmetic ones
+// (voicelines) are gated by wall-clock cooldowns and must not shift the gameplay sequence.
+enum class RNG_STREAM
+{
+	GAMEPLAY = 0,
+	COSMETIC = 1,
+	STREAM_COUNT = COSMETIC + 1
+};
+
+// Reseed every stream from one 64-bit seed.
+void rng_seed(uint64_t seed);
+
+// Seed the streams were last reseeded with.
+uint64_t rng_current_seed();
+
+// A fresh nondeterministic seed (std::random_device), for runs that are not being replayed.
+uint64_t rng_entropy_seed();
+
+// Uniform integer in [lo, hi].
+int rng_int(RNG_STREAM stream, int lo, int hi);
+
+// Uniform float in [0, 1).
+float rng_uniform(RNG_STREAM stream);
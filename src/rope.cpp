@@ -0,0 +1,160 @@
+// internal
+#include "rope.hpp"
+
+#include <chrono>
+#include <cmath>
+
+void rope_init(Rope &rope, vec2 start, vec2 end, int segments)
+{
+  const int count = std::max(segments, 1) + 1;
+
+  rope.x.resize(count);
+  rope.y.resize(count);
+  rope.prev_x.resize(count);
+  rope.prev_y.resize(count);
+  rope.inv_mass.resize(count);
+
+  for (int i = 0; i < count; i++)
+  {
+    float t = (float)i / (float)(count - 1);
+    rope.x[i] = rope.prev_x[i] = start.x + (end.x - start.x) * t;
+    rope.y[i] = rope.prev_y[i] = start.y + (end.y - start.y) * t;
+    rope.inv_mass[i] = 1.f;
+  }
+
+  // both ends are pinned
+  rope.inv_mass[0] = 0.f;
+  rope.inv_mass[count - 1] = 0.f;
+}
+
+// One relaxation pass over every other segment. Segments of the same parity share no
+// particles, so the loop body has no cross-iteration dependency and vectorizes.
+static void rope_solve_parity(Rope &rope, int parity, float segment_length)
+{
+  float *x = rope.x.data();
+  float *y = rope.y.data();
+  const float *w = rope.inv_mass.data();
+  const int last = (int)rope.x.size() - 1;
+
+  for (int i = parity; i < last; i += 2)
+  {
+    float dx = x[i + 1] - x[i];
+    float dy = y[i + 1] - y[i];
+    float dist = std::sqrt(dx * dx + dy * dy) + 1e-6f;
+    float wsum = w[i] + w[i + 1] + 1e-6f;
+    float k = (dist - segment_length) / (dist * wsum);
+
+    x[i] += w[i] * k * dx;
+    y[i] += w[i] * k * dy;
+    x[i + 1] -= w[i + 1] * k * dx;
+    y[i + 1] -= w[i + 1] * k * dy;
+  }
+}
+
+static bool rope_overlap_callback(b2ShapeId shapeId, void *context)
+{
+  *(bool *)context = true;
+  return false; // one hit is enough
+}
+
+// Push particles that moved into terrain back out along the surface normal.
+// A single AABB query over the whole rope gates the per-particle rays, so a rope
+// hanging in open air costs one broadphase query.
+static void rope_collide(Rope &rope, b2WorldId worldId)
+{
+  const int count = (int)rope.x.size();
+  const b2QueryFilter filter = grapple_query_filter();
+
+  b2AABB bounds = {{rope.x[0], rope.y[0]}, {rope.x[0], rope.y[0]}};
+  for (int i = 1; i < count; i++)
+  {
+    bounds.lowerBound.x = std::min(bounds.lowerBound.x, std::min(rope.x[i], rope.prev_x[i]));
+    bounds.lowerBound.y = std::min(bounds.lowerBound.y, std::min(rope.y[i], rope.prev_y[i]));
+    bounds.upperBound.x = std::max(bounds.upperBound.x, std::max(rope.x[i], rope.prev_x[i]));
+    bounds.upperBound.y = std::max(bounds.upperBound.y, std::max(rope.y[i], rope.prev_y[i]));
+  }
+
+  bool nearTerrain = false;
+  b2World_OverlapAABB(worldId, bounds, filter, rope_overlap_callback, &nearTerrain);
+  if (!nearTerrain)
+  {
+    return;
+  }
+
+  for (int i = 1; i < count - 1; i++)
+  {
+    b2Vec2 from = {rope.prev_x[i], rope.prev_y[i]};
+    b2Vec2 translation = {rope.x[i] - from.x, rope.y[i] - from.y};
+    float len = b2Length(translation);
+    if (len < 1e-3f)
+    {
+      continue;
+    }
+
+    // extend the ray by the rope radius so particles stop just short of the surface
+    translation = b2MulSV((len + GRAPPLE_ROPE_RADIUS) / len, translation);
+    b2RayResult result = b2World_CastRayClosest(worldId, from, translation, filter);
+    rope.ray_count++;
+
+    if (result.hit)
+    {
+      rope.x[i] = result.point.x + result.normal.x * GRAPPLE_ROPE_RADIUS;
+      rope.y[i] = result.point.y + result.normal.y * GRAPPLE_ROPE_RADIUS;
+    }
+  }
+}
+
+void rope_step(Rope &rope, b2WorldId worldId, vec2 start, vec2 end, float rest_length, float dt)
+{
+  auto t0 = std::chrono::high_resolution_clock::now();
+
+  const int count = (int)rope.x.size();
+  if (count < 2)
+  {
+    return;
+  }
+  rope.ray_count = 0;
+
+  float *x = rope.x.data();
+  float *y = rope.y.data();
+  float *px = rope.prev_x.data();
+  float *py = rope.prev_y.data();
+  const float *w = rope.inv_mass.data();
+
+  // Verlet integration (pinned particles have w == 0 and do not move)
+  const float gravity_step = GRAVITY * dt * dt;
+  for (int i = 0; i < count; i++)
+  {
+    float vx = (x[i] - px[i]) * GRAPPLE_ROPE_DAMPING;
+    float vy = (y[i] - py[i]) * GRAPPLE_ROPE_DAMPING;
+    px[i] = x[i];
+    py[i] = y[i];
+    x[i] += w[i] * vx;
+    y[i] += w[i] * (vy + gravity_step);
+  }
+
+  x[0] = start.x;
+  y[0] = start.y;
+  x[count - 1] = end.x;
+  y[count - 1] = end.y;
+
+  // Distance constraints, fixed number of passes
+  const float segment_length = rest_length / (float)(count - 1);
+  for (int iter = 0; iter < GRAPPLE_ROPE_ITERATIONS; iter++)
+  {
+    rope_solve_parity(rope, 0, segment_length);
+    rope_solve_parity(rope, 1, segment_length);
+  }
+
+  if (b2World_IsValid(worldId))
+  {
+    rope_collide(rope, worldId);
+  }
+
+  auto t1 = std::chrono::high_resolution_clock::now();
+  rope.step_us = std::chrono::duration<float, std::micro>(t1 - t0).count();
+  if (rope.step_us > GRAPPLE_ROPE_BUDGET_US)
+  {
+    rope.budget_overruns++;
+  }
+}
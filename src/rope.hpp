@@ -0,0 +1,18 @@
+#pragma once
+
+#include "common.hpp"
+#include "tinyECS/components.hpp"
+
+#include <box2d/box2d.h>
+
+// Verlet rope for the grapple (see GRAPPLE_ROPE_MODE).
+// The distance joint still drives the ball; the rope is what gets drawn, and it wraps around terrain.
+// Nothing in here touches GL, so it can be stepped headless.
+
+// lay out `segments` segments in a straight line from start to end
+void rope_init(Rope &rope, vec2 start, vec2 end, int segments);
+
+// advance one frame: integrate, GRAPPLE_ROPE_ITERATIONS constraint passes, terrain collision.
+// start/end are pinned (ball and anchor), rest_length is the total rope length.
+// Passing an invalid worldId skips terrain collision.
+void rope_step(Rope &rope, b2WorldId worldId, vec2 start, vec2 end, float rest_length, float dt);
@@ -2,109 +2,252 @@
 
 #include "common.hpp"
 #include "world_init.hpp"
-#include "world_system.hpp"
 #include "tinyECS/registry.hpp"
+#include "terrain.hpp"
+
+std::vector<TerrainChain> level_terrain_chains;
+unsigned int level_terrain_version = 0;
 
 /**
- * @brief Creates a vertical wall centered at the specified position.
+ * @brief Adds a vertical wall centered at the specified position to the terrain body.
  *
- * This function creates a static vertical wall with the given height and a fixed width of 1 unit,
- * centered at the specified (x, y) position.
+ * This function attaches a box shape with the given height and a fixed width of WALL_DEFAULT_THICKNESS,
+ * centered at the specified (x, y) position, to the shared static terrain body.
  *
- * @param worldId The ID of the Box2D world where the wall will be created.
+ * @param terrainBodyId The static body returned by create_static_terrain().
  * @param x The x-coordinate of the wall's center position.
  * @param y The y-coordinate of the wall's center position.
  * @param height The full height of the wall.
- * @return b2BodyId The ID of the created wall body in the Box2D world.
  */
-b2BodyId create_vertical_wall(b2WorldId worldId, float x, float y, float height)
+void create_vertical_wall(b2BodyId terrainBodyId, float x, float y, float height)
 {
     float halfWidth = WALL_DEFAULT_THICKNESS / 2.0f;
     float halfHeight = height / 2.0f;
 
-    b2BodyDef bodyDef = b2DefaultBodyDef();
-    bodyDef.position = b2Vec2{x, y};
-
-    b2BodyId bodyId = b2CreateBody(worldId, &bodyDef);
-
-    b2Polygon polygon = b2MakeBox(halfWidth, halfHeight);
+    // the terrain body sits at the origin, so the offset is the world position.
+    b2Polygon polygon = b2MakeOffsetBox(halfWidth, halfHeight, b2Vec2{x, y}, 0.0f);
     b2ShapeDef shapeDef = b2DefaultShapeDef();
     shapeDef.friction = 0.1f;
-    b2CreatePolygonShape(bodyId, &shapeDef, &polygon);
-
-    // create PhysicsBody component
-    Entity entity = Entity();
-    PhysicsBody &physicsBody = registry.physicsBodies.emplace(entity);
-    physicsBody.bodyId = bodyId;
-
-    return bodyId;
+    shapeDef.filter = collision_filter(CATEGORY_TERRAIN);
+    b2CreatePolygonShape(terrainBodyId, &shapeDef, &polygon);
 };
 
 /**
- * @brief Creates a horizontal wall centered at the specified position.
+ * @brief Adds a horizontal wall centered at the specified position to the terrain body.
  *
- * This function creates a static horizontal wall with the given width and a fixed height of 1 unit,
- * centered at the specified (x, y) position.
+ * This function attaches a box shape with the given width and a fixed height of WALL_DEFAULT_THICKNESS,
+ * centered at the specified (x, y) position, to the shared static terrain body.
  *
- * @param worldId The ID of the Box2D world where the wall will be created.
+ * @param terrainBodyId The static body returned by create_static_terrain().
  * @param x The x-coordinate of the wall's center position.
  * @param y The y-coordinate of the wall's center position.
  * @param width The full width of the wall.
- * @return b2BodyId The ID of the created wall body in the Box2D world.
  */
-b2BodyId create_horizontal_wall(b2WorldId worldId, float x, float y, float width)
+void create_horizontal_wall(b2BodyId terrainBodyId, float x, float y, float width)
 {
     float halfWidth = width / 2.0f;
     float halfHeight = WALL_DEFAULT_THICKNESS / 2.0f;
 
-    b2BodyDef bodyDef = b2DefaultBodyDef();
-    bodyDef.position = b2Vec2{x, y};
-
-    b2BodyId bodyId = b2CreateBody(worldId, &bodyDef);
-
-    b2Polygon polygon = b2MakeBox(halfWidth, halfHeight);
+    b2Polygon polygon = b2MakeOffsetBox(halfWidth, halfHeight, b2Vec2{x, y}, 0.0f);
     b2ShapeDef shapeDef = b2DefaultShapeDef();
     shapeDef.friction = 0.1f;
-    b2CreatePolygonShape(bodyId, &shapeDef, &polygon);
-
-    // create PhysicsBody component
-    Entity entity = Entity();
-    PhysicsBody &physicsBody = registry.physicsBodies.emplace(entity);
-    physicsBody.bodyId = bodyId;
-
-    return bodyId;
+    shapeDef.filter = collision_filter(CATEGORY_TERRAIN);
+    b2CreatePolygonShape(terrainBodyId, &shapeDef, &polygon);
 };
 
-b2BodyId create_chain(b2WorldId worldId, std::vector<vec2> points, bool isLoop, std::vector<Entity>& linesArrayRef) {
+void clear_terrain_chains()
+{
+    level_terrain_chains.clear();
+}
+
+void create_chain(std::vector<vec2> points, bool isLoop)
+{
     // convert the coords to world space.
-    std::vector<b2Vec2> translatedVertices;
-    translatedVertices.reserve(points.size());
-    for (const auto &vertex : points)
+    for (vec2 &vertex : points)
+    {
+        vertex *= (float)TILED_TO_GRID_PIXEL_SCALE;
+    }
+
+    level_terrain_chains.push_back({simplify_chain(points, isLoop), isLoop});
+}
+
+// perpendicular distance of b from the line through a and c
+static float distance_from_line(vec2 a, vec2 b, vec2 c)
+{
+    vec2 ac = c - a;
+    float len = length(ac);
+    if (len <= TERRAIN_WELD_TOLERANCE)
     {
-        translatedVertices.push_back(b2Vec2{
-            vertex.x * TILED_TO_GRID_PIXEL_SCALE,
-            vertex.y * TILED_TO_GRID_PIXEL_SCALE,
-        });
+        return length(b - a);
     }
+    return abs(ac.x * (b.y - a.y) - ac.y * (b.x - a.x)) / len;
+}
 
-    // Create a Box2D chain shape based on the translated vertices
-    b2ChainDef chainDef = b2DefaultChainDef();
-    chainDef.count = translatedVertices.size();
-    chainDef.points = translatedVertices.data();
+// Douglas-Peucker on points[first..last]: keeps the vertex farthest from the chord first-last
+// if it is off by more than the tolerance, and recurses on both halves. Every dropped vertex is
+// within the tolerance of the final segment that replaces it, so error can't pile up along curves.
+static void douglas_peucker(const std::vector<vec2> &points, size_t first, size_t last, std::vector<bool> &keep)
+{
+    if (last <= first + 1)
+    {
+        return;
+    }
+    size_t farthest = first;
+    float max_distance = 0.f;
+    for (size_t i = first + 1; i < last; i++)
+    {
+        float d = distance_from_line(points[first], points[i], points[last]);
+        if (d > max_distance)
+        {
+            max_distance = d;
+            farthest = i;
+        }
+    }
+    if (max_distance <= TERRAIN_COLLINEAR_TOLERANCE)
+    {
+        return;
+    }
+    keep[farthest] = true;
+    douglas_peucker(points, first, farthest, keep);
+    douglas_peucker(points, farthest, last, keep);
+}
 
-    chainDef.isLoop = isLoop;
-    chainDef.friction = TERRAIN_DEFAULT_FRICTION;
-    chainDef.restitution = TERRAIN_DEFAULT_RESTITUTION;
+/**
+ * @brief Welds coincident vertices and drops vertices that lie on a straight run (Douglas-Peucker).
+ *
+ * Box2D treats the first and last point of an open chain as ghost vertices (they only
+ * smooth the collision at the ends), so those and their neighbours are never removed.
+ * A chain that welds down to fewer than the 4 points Box2D needs comes back welded and short;
+ * build_static_terrain_body() skips it.
+ */
+std::vector<vec2> simplify_chain(const std::vector<vec2> &points, bool isLoop)
+{
+    const size_t min_points = 4;
 
+    // 1. weld consecutive coincident vertices
+    std::vector<vec2> welded;
+    welded.reserve(points.size());
+    for (const vec2 &p : points)
+    {
+        if (welded.empty() || length(p - welded.back()) > TERRAIN_WELD_TOLERANCE)
+        {
+            welded.push_back(p);
+        }
+    }
+    // a loop closes itself, so a repeated first point is redundant
+    if (isLoop && welded.size() > 1 && length(welded.front() - welded.back()) <= TERRAIN_WELD_TOLERANCE)
+    {
+        welded.pop_back();
+    }
+    if (welded.size() <= min_points)
+    {
+        return welded;
+    }
+
+    // 2. merge collinear runs
+    const size_t n = welded.size();
+    std::vector<bool> keep(n, false);
+    if (isLoop)
+    {
+        // split the loop at vertex 0 and the vertex farthest from it, and simplify both halves
+        size_t opposite = 1;
+        for (size_t i = 2; i < n; i++)
+        {
+            if (length(welded[i] - welded[0]) > length(welded[opposite] - welded[0]))
+            {
+                opposite = i;
+            }
+        }
+        std::vector<vec2> closed = welded;
+        closed.push_back(welded[0]);
+        std::vector<bool> closed_keep(n + 1, false);
+        douglas_peucker(closed, 0, opposite, closed_keep);
+        douglas_peucker(closed, opposite, n, closed_keep);
+        for (size_t i = 0; i < n; i++)
+        {
+            keep[i] = closed_keep[i];
+        }
+        keep[0] = keep[opposite] = true;
+    }
+    else
+    {
+        // ghost vertices and their neighbours stay
+        keep[0] = keep[1] = keep[n - 2] = keep[n - 1] = true;
+        douglas_peucker(welded, 1, n - 2, keep);
+    }
+
+    std::vector<vec2> simplified;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (keep[i])
+        {
+            simplified.push_back(welded[i]);
+        }
+    }
+    // a loop that collapses below what Box2D needs keeps its welded shape
+    return simplified.size() < min_points ? welded : simplified;
+}
+
+b2BodyId build_static_terrain_body(b2WorldId worldId, float roomWidth, float roomHeight)
+{
     b2BodyDef bodyDef = b2DefaultBodyDef();
+    bodyDef.type = b2_staticBody;
     b2BodyId bodyId = b2CreateBody(worldId, &bodyDef);
-    b2CreateChain(bodyId, &chainDef);
 
-    // create physicsBody component to track the terrain shapes.
+    for (const TerrainChain &chain : level_terrain_chains)
+    {
+        // Box2D chains need at least 4 points; shorter ones welded away to nothing useful
+        if (chain.points.size() < 4)
+        {
+            continue;
+        }
+
+        std::vector<b2Vec2> translatedVertices;
+        translatedVertices.reserve(chain.points.size());
+        for (const vec2 &vertex : chain.points)
+        {
+            translatedVertices.push_back(b2Vec2{vertex.x, vertex.y});
+        }
+
+        // Create a Box2D chain shape based on the translated vertices
+        b2ChainDef chainDef = b2DefaultChainDef();
+        chainDef.count = translatedVertices.size();
+        chainDef.points = translatedVertices.data();
+
+        chainDef.isLoop = chain.isLoop;
+        chainDef.friction = TERRAIN_DEFAULT_FRICTION;
+        chainDef.restitution = TERRAIN_DEFAULT_RESTITUTION;
+        chainDef.filter = collision_filter(CATEGORY_TERRAIN);
+
+        b2CreateChain(bodyId, &chainDef);
+    }
+
+    // Room boundaries live on the same body
+    create_horizontal_wall(bodyId, roomWidth / 2, 0.0f, roomWidth);          // Floor
+    create_horizontal_wall(bodyId, roomWidth / 2, roomHeight, roomWidth);    // Ceiling
+    create_vertical_wall(bodyId, 0.0f, roomHeight / 2, roomHeight);          // Left Wall
+    create_vertical_wall(bodyId, roomWidth, roomHeight / 2, roomHeight);     // Right Wall
+
+    return bodyId;
+}
+
+b2BodyId create_static_terrain(b2WorldId worldId, float roomWidth, float roomHeight)
+{
+    b2BodyId bodyId = build_static_terrain_body(worldId, roomWidth, roomHeight);
+
+    size_t vertex_count = 0;
+    for (const TerrainChain &chain : level_terrain_chains)
+    {
+        vertex_count += chain.points.size();
+    }
+    std::cout << "Static terrain: " << level_terrain_chains.size() << " chains, " << vertex_count << " vertices on one body." << std::endl;
+
+    // create physicsBody component to track the terrain body.
     Entity entity = Entity();
-    PhysicsBody& pb = registry.physicsBodies.emplace(entity);
-	  pb.bodyId = bodyId;
+    PhysicsBody &pb = registry.physicsBodies.emplace(entity);
+    pb.bodyId = bodyId;
 
+    level_terrain_version++;
     return bodyId;
 }
 
@@ -3,12 +3,35 @@
 #include <box2d/box2d.h>
 #include <iostream>
 
-b2BodyId create_vertical_wall(b2WorldId worldId, float x, float y, float height);
-b2BodyId create_horizontal_wall(b2WorldId worldId, float x, float y, float width);
+// A terrain chain as read from the level file, in world coordinates.
+struct TerrainChain
+{
+    std::vector<vec2> points;
+    bool isLoop;
+};
+
+// Chains collected by load_level() for the current level (after welding/simplification).
+// Kept around so other systems can rebuild terrain geometry without re-reading the .tmj.
+extern std::vector<TerrainChain> level_terrain_chains;
+// Bumped every time create_static_terrain() builds a level, so caches derived from the chains know to rebuild.
+extern unsigned int level_terrain_version;
+
+void create_vertical_wall(b2BodyId terrainBodyId, float x, float y, float height);
+void create_horizontal_wall(b2BodyId terrainBodyId, float x, float y, float width);
 
 //////////////////////////////////////////////////////////////
 // Should only be used by the load_level() funciton. Doesn't render textures, assume map textures are overlayed ontop.
+// Chains are only queued here; create_static_terrain() turns them into shapes.
 //////////////////////////////////////////////////////////////
-b2BodyId create_chain(b2WorldId worldId, std::vector<vec2> points, bool isLoop, std::vector<Entity>& linesArrayRef);
+void clear_terrain_chains();
+void create_chain(std::vector<vec2> points, bool isLoop);
+
+// Builds ONE static body holding every queued chain plus the four room walls.
+b2BodyId create_static_terrain(b2WorldId worldId, float roomWidth, float roomHeight);
+// Same body, but without registering it with the ECS (for shadow worlds, tools, benchmarks).
+b2BodyId build_static_terrain_body(b2WorldId worldId, float roomWidth, float roomHeight);
+
+// Removes coincident vertices and merges (near-)collinear segments. Exposed for tooling.
+std::vector<vec2> simplify_chain(const std::vector<vec2> &points, bool isLoop);
 
 void spawnEnemyAtTile(b2WorldId worldId, bool predicate, ENEMY_TYPES enemy_type, int quantity, vec2 tile_position, ivec2 tile_movement_point_a, ivec2 tile_movement_point_b);
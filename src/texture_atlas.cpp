@@ -0,0 +1,73 @@
+#include "texture_atlas.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+
+AtlasLayout pack_texture_atlas(const std::vector<ivec2> &sizes, int page_size, int padding)
+{
+	AtlasLayout layout;
+	layout.placements.resize(sizes.size(), {-1, ivec2(0)});
+
+	// tallest first keeps the rows tight
+	std::vector<size_t> order(sizes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a].y > sizes[b].y; });
+
+	int page = -1;
+	ivec2 cursor = ivec2(0); // where the next image goes in the current row
+	int row_height = 0;
+	for (size_t i : order)
+	{
+		const ivec2 padded = sizes[i] + ivec2(2 * padding);
+		assert(padded.x <= page_size && padded.y <= page_size);
+
+		// row full: start the next one above it
+		if (page >= 0 && cursor.x + padded.x > page_size)
+		{
+			cursor = ivec2(0, cursor.y + row_height);
+			row_height = 0;
+		}
+		// page full (or none yet): start a new page
+		if (page < 0 || cursor.y + padded.y > page_size)
+		{
+			page++;
+			layout.page_extents.push_back(ivec2(0));
+			cursor = ivec2(0);
+			row_height = 0;
+		}
+
+		layout.placements[i] = {page, cursor + ivec2(padding)};
+		cursor.x += padded.x;
+		row_height = std::max(row_height, padded.y);
+
+		ivec2 &extent = layout.page_extents[page];
+		extent = glm::max(extent, ivec2(cursor.x, cursor.y + row_height));
+	}
+	return layout;
+}
+
+void blit_into_atlas_page(uint8_t *page, int page_width, ivec2 position, const uint8_t *image, ivec2 size, int padding)
+{
+	const size_t texel = 4;
+	for (int y = -padding; y < size.y + padding; y++)
+	{
+		const uint8_t *src = image + (size_t)std::clamp(y, 0, size.y - 1) * size.x * texel;
+		uint8_t *dst = page + ((size_t)(position.y + y) * page_width + position.x) * texel;
+
+		std::memcpy(dst, src, (size_t)size.x * texel);
+		for (int x = 1; x <= padding; x++)
+		{
+			std::memcpy(dst - x * texel, src, texel);
+			std::memcpy(dst + (size.x - 1 + x) * texel, src + (size.x - 1) * texel, texel);
+		}
+	}
+}
+
+vec4 atlas_uv_rect(const AtlasPlacement &placement, ivec2 size, ivec2 page_extent)
+{
+	const vec2 lo = vec2(placement.position) / vec2(page_extent);
+	const vec2 hi = vec2(placement.position + size) / vec2(page_extent);
+	return {lo.x, lo.y, hi.x, hi.y};
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Where one image landed in the atlas
+struct AtlasPlacement
+{
+	int page;
+	ivec2 position; // lower left texel of the image itself, inside its padding
+};
+
+// Result of packing: one placement per input size (same order) and the used extent of every
+// page, so the last page can be allocated no bigger than it needs to be
+struct AtlasLayout
+{
+	std::vector<AtlasPlacement> placements;
+	std::vector<ivec2> page_extents;
+};
+
+// Shelf packer: images go tallest first into rows filled left to right, a new row starts when
+// one is full and a new page when a row no longer fits. Every image keeps padding texels on
+// each side, which blit_into_atlas_page fills with copies of its edge so linear filtering
+// never reads a neighbour. Images must fit a page with their padding.
+AtlasLayout pack_texture_atlas(const std::vector<ivec2> &sizes, int page_size, int padding);
+
+// Copy an RGBA8 image into an RGBA8 page (both row-major, rows of page_width texels) at
+// position, extruding its edge into the padding around it
+void blit_into_atlas_page(uint8_t *page, int page_width, ivec2 position, const uint8_t *image, ivec2 size, int padding);
+
+// Rect of an image on its page, as {u0, v0, u1, v1}
+vec4 atlas_uv_rect(const AtlasPlacement &placement, ivec2 size, ivec2 page_extent);
@@ -0,0 +1,89 @@
+#include "tile_map.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+TileLayer level_tile_layer;
+unsigned int level_tile_layer_version = 0;
+
+// Value of name="..." inside one XML tag, or "" if the tag doesn't have it.
+// .tsx files are flat enough that this is all the XML we need.
+static std::string xml_attribute(const std::string &tag, const std::string &name)
+{
+  const std::string key = " " + name + "=\"";
+  const size_t start = tag.find(key);
+  if (start == std::string::npos)
+    return "";
+  const size_t value = start + key.size();
+  return tag.substr(value, tag.find('"', value) - value);
+}
+
+static int xml_int(const std::string &tag, const std::string &name, int fallback = 0)
+{
+  const std::string value = xml_attribute(tag, name);
+  return value.empty() ? fallback : std::stoi(value);
+}
+
+// The tag starting at pos (from '<' to '>')
+static std::string xml_tag(const std::string &xml, size_t pos)
+{
+  return xml.substr(pos, xml.find('>', pos) - pos + 1);
+}
+
+bool load_tileset(const std::string &tsx_path, uint32_t first_gid, std::unordered_map<uint32_t, TilesetTile> &tiles)
+{
+  std::ifstream infile(tsx_path);
+  if (infile.fail())
+  {
+    std::cerr << "Could not open tileset " << tsx_path << std::endl;
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << infile.rdbuf();
+  const std::string xml = buffer.str();
+
+  const size_t tileset_pos = xml.find("<tileset");
+  if (tileset_pos == std::string::npos)
+    return false;
+  const std::string tileset = xml_tag(xml, tileset_pos);
+  const ivec2 tile_size = ivec2(xml_int(tileset, "tilewidth"), xml_int(tileset, "tileheight"));
+  const int spacing = xml_int(tileset, "spacing");
+  const int margin = xml_int(tileset, "margin");
+  const int columns = xml_int(tileset, "columns");
+  const int tile_count = xml_int(tileset, "tilecount");
+
+  // images are relative to the .tsx
+  const size_t slash = tsx_path.find_last_of('/');
+  const std::string directory = slash == std::string::npos ? "" : tsx_path.substr(0, slash + 1);
+
+  // collection of images: one <tile id="..."><image .../></tile> per tile
+  bool collection = false;
+  for (size_t pos = xml.find("<tile "); pos != std::string::npos; pos = xml.find("<tile ", pos + 1))
+  {
+    const std::string tile = xml_tag(xml, pos);
+    const size_t end = xml.find("</tile>", pos);
+    const size_t image_pos = xml.find("<image", pos);
+    if (image_pos == std::string::npos || image_pos > end)
+      continue; // per-tile properties or collision shapes only
+
+    const std::string image = xml_tag(xml, image_pos);
+    tiles[first_gid + xml_int(tile, "id")] = {directory + xml_attribute(image, "source"), ivec2(0),
+                                              ivec2(xml_int(image, "width"), xml_int(image, "height"))};
+    collection = true;
+  }
+  if (collection)
+    return true;
+
+  // one sheet cut into a grid
+  const size_t image_pos = xml.find("<image", tileset_pos);
+  if (image_pos == std::string::npos || columns <= 0)
+    return false;
+  const std::string image = directory + xml_attribute(xml_tag(xml, image_pos), "source");
+  for (int id = 0; id < tile_count; id++)
+  {
+    const ivec2 cell = ivec2(id % columns, id / columns);
+    tiles[first_gid + id] = {image, ivec2(margin) + cell * (tile_size + spacing), tile_size};
+  }
+  return true;
+}
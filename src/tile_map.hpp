@@ -0,0 +1,47 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Tiled keeps flips in the top bits of every gid
+const uint32_t TILE_FLIPPED_HORIZONTALLY = 0x80000000u;
+const uint32_t TILE_FLIPPED_VERTICALLY = 0x40000000u;
+const uint32_t TILE_FLIPPED_DIAGONALLY = 0x20000000u;
+const uint32_t TILE_GID_MASK = 0x0fffffffu; // also drops the hexagonal rotation bit
+
+// A tileset the map uses, from its first gid on
+struct TilesetRef
+{
+  uint32_t first_gid;
+  std::string source; // .tsx path as written in the map, relative to LEVEL_DIR_FILEPATH
+};
+
+// The tile layer of a Tiled map: the level art as tile ids
+struct TileLayer
+{
+  ivec2 size = ivec2(0);      // in map tiles
+  ivec2 tile_size = ivec2(0); // map tile size in px
+  std::vector<uint32_t> gids; // row-major, top row first as in Tiled, flip bits included; 0 is empty
+  std::vector<TilesetRef> tilesets;
+};
+
+// Tile layer read by load_level_file() for the current level (empty if the map has none).
+extern TileLayer level_tile_layer;
+// Bumped by every load_level_file(), so the renderer knows to rebuild its tile chunks.
+extern unsigned int level_tile_layer_version;
+
+// One tile of a tileset: a rect of an image file
+struct TilesetTile
+{
+  std::string image;
+  ivec2 origin; // from the image's top left, as Tiled counts
+  ivec2 size;
+};
+
+// Reads a Tiled .tsx tileset, either one sheet cut into a grid or a collection of images, and
+// adds its tiles to tiles keyed by gid. Image paths come back relative to the working directory.
+bool load_tileset(const std::string &tsx_path, uint32_t first_gid, std::unordered_map<uint32_t, TilesetTile> &tiles);
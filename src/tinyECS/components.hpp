@@ -84,6 +84,16 @@ struct Enemy
   // Patrol boundary for obstacles (a_x, a_y), (b_x, b_y).
   vec2 movement_area_point_a;
   vec2 movement_area_point_b;
+
+  // AI level of detail (see AI_LOD_* in common.hpp)
+  int ai_lod_band = 0;                // AI_LOD_NEAR / AI_LOD_MID / AI_LOD_FAR
+  int ai_lod_phase = 0;               // which of every AI_LOD_MID_INTERVAL ticks it runs on while MID
+  float ai_accumulated_ms = 0.f;      // time since this enemy's AI last ran
+  vec2 ai_last_force = {0.f, 0.f};    // reapplied on ticks where the AI is skipped
+
+  // Counts down from ENEMY_AWARENESS_MEMORY_MS after the enemy last had line of sight to the player.
+  // Enemies only pursue while this is above 0.
+  float awareness_ms = 0.f;
 };
 
 // All data relevant to the shape and motion of entities
@@ -313,9 +323,10 @@ enum class TEXTURE_ASSET_ID
   LEVEL_UNDER = LEVEL_LAB + 1,
   LEVEL_SNAKE = LEVEL_UNDER + 1,
   LEVEL_TUNNELSMALL = LEVEL_SNAKE + 1,
+  LEVEL_TUNNEL = LEVEL_TUNNELSMALL + 1,
 
   // Parallax
-  BACKGROUND_0 = LEVEL_TUNNELSMALL + 1,
+  BACKGROUND_0 = LEVEL_TUNNEL + 1,
   BACKGROUND_1 = BACKGROUND_0 + 1,
   BACKGROUND_2 = BACKGROUND_1 + 1,
   BACKGROUND_3 = BACKGROUND_2 + 1,
@@ -451,7 +462,8 @@ enum class EFFECT_ASSET_ID
   TRANSLUCENT = PARALLAX + 1,
   FIREBALL = TRANSLUCENT + 1,
   RAMSTER = FIREBALL + 1,
-  EFFECT_COUNT = RAMSTER + 1
+  SPRITE_INSTANCED = RAMSTER + 1, // batched TEXTURED/TRANSLUCENT/FIREBALL/RAMSTER sprites
+  EFFECT_COUNT = SPRITE_INSTANCED + 1
 };
 const int effect_count = (int)EFFECT_ASSET_ID::EFFECT_COUNT;
 
@@ -461,8 +473,10 @@ enum class GEOMETRY_BUFFER_ID
   SPRITE = LEGACY_CHICKEN + 1,
   LEGACY_EGG = SPRITE + 1,
   DEBUG_LINE = LEGACY_EGG + 1,
-  SCREEN_TRIANGLE = DEBUG_LINE + 1,
-  GEOMETRY_COUNT = SCREEN_TRIANGLE + 1
+  ROPE_STRIP = DEBUG_LINE + 1, // streamed every frame by drawRope()
+  SCREEN_TRIANGLE = ROPE_STRIP + 1,
+  SPRITE_INSTANCES = SCREEN_TRIANGLE + 1, // streamed per batch by flushSprites()
+  GEOMETRY_COUNT = SPRITE_INSTANCES + 1
 };
 const int geometry_count = (int)GEOMETRY_BUFFER_ID::GEOMETRY_COUNT;
 
@@ -479,6 +493,25 @@ struct Animation
   }
 };
 
+// Draw order of a render request, bottom to top. Set when the entity is created; the
+// render queue sorts on it first, so nothing in a higher layer is drawn under a lower one.
+enum class RENDER_LAYER
+{
+  GRID = 0,
+  BACKGROUND = GRID + 1,    // parallax
+  LEVEL = BACKGROUND + 1,   // the level png
+  WORLD = LEVEL + 1,        // enemies, grapple points, confetti...
+  LINES = WORLD + 1,        // grapple line
+  ROPES = LINES + 1,        // rope and trajectory arc, not render requests (see RenderSystem::draw)
+  PLAYER_BACK = ROPES + 1,
+  PLAYER_MID = PLAYER_BACK + 1,
+  PLAYER_TOP = PLAYER_MID + 1,
+  FIREBALLS = PLAYER_TOP + 1,
+  UI = FIREBALLS + 1,
+  SCREEN = UI + 1,          // menu and story screen elements, not drawn while playing
+  LAYER_COUNT = SCREEN + 1
+};
+
 struct RenderRequest
 {
   TEXTURE_ASSET_ID used_texture = TEXTURE_ASSET_ID::TEXTURE_COUNT;
@@ -493,6 +526,7 @@ struct RenderRequest
   float animation_frame_time = 0;                 // time per frame in ms
   float animation_elapsed_time = 0;               // relative elapsed time
   int animation_current_frame = 0;                // current frame index
+  RENDER_LAYER layer = RENDER_LAYER::WORLD;
 };
 
 struct FireBall
@@ -543,36 +577,41 @@ struct Line
   vec2 end_pos = {10, 10}; // default to diagonal line
 };
 
-struct EnemyPhysics
-{
-  bool isGrounded;
-};
-
-struct LevelLayer
+// Predicted path of the ball if the grapple were shot at the cursor
+struct TrajectoryArc
 {
+  std::vector<vec2> points;
 };
 
-struct BackgroundLayer
+// Segmented grapple rope (GRAPPLE_ROPE_MODE), particles stored as parallel arrays for rope_step()
+struct Rope
 {
+  std::vector<float> x, y;
+  std::vector<float> prev_x, prev_y;
+  std::vector<float> inv_mass; // 0 for the pinned ends
+  float step_us = 0.f;         // cost of the last rope_step()
+  int ray_count = 0;           // terrain rays cast by the last rope_step()
+  int budget_overruns = 0;     // frames over GRAPPLE_ROPE_BUDGET_US
 };
 
-struct PlayerRotatableLayer
+struct EnemyPhysics
 {
+  bool isGrounded;
 };
 
-struct PlayerNonRotatableLayer
+struct LevelLayer
 {
 };
 
-struct PlayerTopLayer
+struct BackgroundLayer
 {
 };
 
-struct PlayerMidLayer
+struct PlayerRotatableLayer
 {
 };
 
-struct PlayerBottomLayer
+struct PlayerNonRotatableLayer
 {
 };
 
@@ -600,10 +639,6 @@ struct Timer
   Entity digits[7];
 };
 
-struct UI
-{
-};
-
 struct LBTimer
 {
   Entity digits[10];
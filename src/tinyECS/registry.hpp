@@ -34,15 +34,14 @@ public:
 	ComponentContainer<EnemyPhysics> enemyPhysics;
 	ComponentContainer<Camera> cameras;
 	ComponentContainer<Line> lines;
+	ComponentContainer<Rope> ropes;
+	ComponentContainer<TrajectoryArc> trajectoryArcs;
 	ComponentContainer<Grapple> grapples;
 	ComponentContainer<GrapplePoint> grapplePoints;
 	ComponentContainer<LevelLayer> levelLayers;
 	ComponentContainer<BackgroundLayer> backgroundLayers;
 	ComponentContainer<PlayerRotatableLayer> playerRotatableLayers;
 	ComponentContainer<PlayerNonRotatableLayer> playerNonRotatableLayers;
-	ComponentContainer<PlayerTopLayer> playerTopLayer;
-	ComponentContainer<PlayerMidLayer> playerMidLayer;
-	ComponentContainer<PlayerBottomLayer> playerBottomLayer;
 	ComponentContainer<GoalZone> goalZones;
 	ComponentContainer<FireBall> fireballs;
 	ComponentContainer<RunAnimation> runAnimations;
@@ -50,7 +49,6 @@ public:
 	ComponentContainer<HealthBar> healthbars;
 	ComponentContainer<Score> scores;
 	ComponentContainer<Timer> timers;
-	ComponentContainer<UI> uis;
 	ComponentContainer<LBTimer> lbtimers;
 
 	// constructor that adds all containers for looping over them
@@ -75,6 +73,8 @@ public:
 		registry_list.push_back(&physicsBodies);
 		registry_list.push_back(&playerPhysics);
 		registry_list.push_back(&lines);
+		registry_list.push_back(&ropes);
+		registry_list.push_back(&trajectoryArcs);
 		registry_list.push_back(&enemyPhysics);
 		registry_list.push_back(&grapples);
 		registry_list.push_back(&grapplePoints);
@@ -86,7 +86,6 @@ public:
 		registry_list.push_back(&healthbars);
 		registry_list.push_back(&scores);
 		registry_list.push_back(&timers);
-		registry_list.push_back(&uis);
 		registry_list.push_back(&lbtimers);
 	}
 
@@ -0,0 +1,125 @@
+// internal
+#include "trajectory_preview.hpp"
+#include "terrain.hpp"
+
+#include <chrono>
+
+TrajectoryPreview::~TrajectoryPreview()
+{
+  destroy();
+}
+
+void TrajectoryPreview::destroy()
+{
+  if (b2World_IsValid(shadowWorldId))
+  {
+    b2DestroyWorld(shadowWorldId);
+  }
+  shadowWorldId = b2_nullWorldId;
+  cache_valid = false;
+  points.clear();
+}
+
+void TrajectoryPreview::rebuild(float roomWidth, float roomHeight)
+{
+  destroy();
+
+  b2WorldDef worldDef = b2DefaultWorldDef();
+  worldDef.gravity = b2Vec2{0.f, GRAVITY};
+  shadowWorldId = b2CreateWorld(&worldDef);
+
+  // static terrain, same geometry and filters as the game world
+  build_static_terrain_body(shadowWorldId, roomWidth, roomHeight);
+
+  // ball, matching createBall()
+  b2BodyDef ballDef = b2DefaultBodyDef();
+  ballDef.type = b2_dynamicBody;
+  ballBodyId = b2CreateBody(shadowWorldId, &ballDef);
+
+  b2ShapeDef shapeDef = b2DefaultShapeDef();
+  shapeDef.density = BALL_DENSTIY;
+  shapeDef.friction = BALL_FRICTION;
+  shapeDef.restitution = BALL_RESTITUTION;
+  shapeDef.filter = collision_filter(CATEGORY_PLAYER);
+  b2Circle circle;
+  circle.center = b2Vec2{0.0f, 0.0f};
+  circle.radius = BALL_RADIUS;
+  b2CreateCircleShape(ballBodyId, &shapeDef, &circle);
+  b2Body_SetAngularDamping(ballBodyId, BALL_ANGULAR_DAMPING);
+
+  // anchor + joint, matching createGrapple()
+  b2BodyDef anchorDef = b2DefaultBodyDef();
+  anchorDef.type = b2_staticBody;
+  anchorBodyId = b2CreateBody(shadowWorldId, &anchorDef);
+
+  b2DistanceJointDef djd = b2DefaultDistanceJointDef();
+  djd.bodyIdA = ballBodyId;
+  djd.bodyIdB = anchorBodyId;
+  djd.length = GRAPPLE_MAX_LENGTH;
+  djd.collideConnected = false;
+  djd.maxLength = GRAPPLE_MAX_LENGTH;
+  djd.minLength = GRAPPLE_MIN_LENGTH;
+  jointId = b2CreateDistanceJoint(shadowWorldId, &djd);
+}
+
+const std::vector<vec2> &TrajectoryPreview::predict(vec2 ballPos, vec2 ballVelocity, float ballAngularVelocity, vec2 anchor, float length)
+{
+  last_cached = false;
+  if (!b2World_IsValid(shadowWorldId))
+  {
+    points.clear();
+    return points;
+  }
+
+  if (cache_valid &&
+      glm::length(ballPos - cached_ball_pos) < GRAPPLE_PREVIEW_POSITION_EPSILON &&
+      glm::length(anchor - cached_anchor) < GRAPPLE_PREVIEW_POSITION_EPSILON &&
+      glm::length(ballVelocity - cached_ball_velocity) < GRAPPLE_PREVIEW_VELOCITY_EPSILON)
+  {
+    last_cached = true;
+    return points;
+  }
+
+  auto t0 = std::chrono::high_resolution_clock::now();
+
+  // put the shadow bodies where the real ones are
+  b2Body_SetTransform(anchorBodyId, b2Vec2{anchor.x, anchor.y}, b2Rot_identity);
+  b2Body_SetTransform(ballBodyId, b2Vec2{ballPos.x, ballPos.y}, b2Rot_identity);
+  b2Body_SetLinearVelocity(ballBodyId, b2Vec2{ballVelocity.x, ballVelocity.y});
+  b2Body_SetAngularVelocity(ballBodyId, ballAngularVelocity);
+  b2Body_SetAwake(ballBodyId, true);
+  b2DistanceJoint_SetLength(jointId, length);
+
+  points.clear();
+  points.push_back(ballPos);
+
+  const int total_steps = (int)(GRAPPLE_PREVIEW_DURATION / GRAPPLE_PREVIEW_STEP);
+  int step = 0;
+  for (; step < total_steps; step++)
+  {
+    b2World_Step(shadowWorldId, GRAPPLE_PREVIEW_STEP, 1);
+
+    if ((step + 1) % GRAPPLE_PREVIEW_SAMPLE_EVERY == 0)
+    {
+      b2Vec2 p = b2Body_GetPosition(ballBodyId);
+      points.push_back(vec2(p.x, p.y));
+
+      // stop early rather than blow the frame budget
+      float spent_us = std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - t0).count();
+      if (spent_us > GRAPPLE_PREVIEW_BUDGET_US)
+      {
+        step++;
+        break;
+      }
+    }
+  }
+
+  last_steps = step;
+  last_cost_us = std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - t0).count();
+
+  cache_valid = true;
+  cached_ball_pos = ballPos;
+  cached_ball_velocity = ballVelocity;
+  cached_anchor = anchor;
+  return points;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <box2d/box2d.h>
+
+// Forward-simulates the ball on a grapple in a private Box2D world that only holds the
+// level's static terrain, the ball and the anchor. The game world is never touched.
+class TrajectoryPreview
+{
+public:
+	~TrajectoryPreview();
+
+	// rebuild the shadow world from level_terrain_chains (call after load_level)
+	void rebuild(float roomWidth, float roomHeight);
+
+	// ball path for the next GRAPPLE_PREVIEW_DURATION seconds if it were grappled to `anchor`.
+	// Returns the previous arc if nothing moved more than the preview epsilons.
+	const std::vector<vec2> &predict(vec2 ballPos, vec2 ballVelocity, float ballAngularVelocity, vec2 anchor, float length);
+
+	// stats for the last predict()
+	float last_cost_us = 0.f;
+	int last_steps = 0;
+	bool last_cached = false;
+
+private:
+	void destroy();
+
+	b2WorldId shadowWorldId = b2_nullWorldId;
+	b2BodyId ballBodyId = b2_nullBodyId;
+	b2BodyId anchorBodyId = b2_nullBodyId;
+	b2JointId jointId = b2_nullJointId;
+
+	// cache
+	bool cache_valid = false;
+	vec2 cached_ball_pos;
+	vec2 cached_ball_velocity;
+	vec2 cached_anchor;
+	std::vector<vec2> points;
+};
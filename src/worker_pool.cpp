@@ -0,0 +1,99 @@
+#include "worker_pool.hpp"
+
+WorkerPool::WorkerPool(int extra_threads)
+{
+	resize(extra_threads);
+}
+
+WorkerPool::~WorkerPool()
+{
+	stop();
+}
+
+void WorkerPool::resize(int extra_threads)
+{
+	stop();
+	// new threads start from the current generation, read here and not when they first run, so a
+	// parallel_for() issued before a thread is scheduled still counts as new to it
+	unsigned int start_generation;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = false;
+		start_generation = generation;
+	}
+	for (int i = 0; i < extra_threads; i++) {
+		threads.emplace_back(&WorkerPool::worker_main, this, i + 1, start_generation);
+	}
+}
+
+void WorkerPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+	threads.clear();
+}
+
+void WorkerPool::parallel_for(int count, const std::function<void(int begin, int end)> &fn)
+{
+	const int total = thread_count();
+	if (count <= 0) {
+		return;
+	}
+	if (total == 1) {
+		fn(0, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &fn;
+		job_count = count;
+		pending = total - 1;
+		generation++;
+	}
+	wake.notify_all();
+
+	// the caller does chunk 0
+	fn(0, count / total);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this] { return pending == 0; });
+	job = nullptr;
+}
+
+void WorkerPool::worker_main(int index, unsigned int seen)
+{
+	while (true) {
+		const std::function<void(int, int)> *fn;
+		int count, total;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return stopping || generation != seen; });
+			if (stopping) {
+				return;
+			}
+			seen = generation;
+			fn = job;
+			count = job_count;
+			total = (int)threads.size() + 1;
+		}
+
+		int begin = (int)((long long)count * index / total);
+		int end = (int)((long long)count * (index + 1) / total);
+		if (begin < end) {
+			(*fn)(begin, end);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending--;
+		}
+		finished.notify_one();
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A few persistent threads for data-parallel loops. parallel_for() cuts [0, count) into one
+// contiguous chunk per thread (the calling thread takes the first) and returns when all are done.
+// Chunk boundaries only depend on count and the thread count, never on timing.
+class WorkerPool
+{
+public:
+	// extra_threads = threads besides the caller; 0 runs everything inline
+	explicit WorkerPool(int extra_threads = 0);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool &) = delete;
+	WorkerPool &operator=(const WorkerPool &) = delete;
+
+	void resize(int extra_threads);
+	int thread_count() const { return (int)threads.size() + 1; }
+
+	void parallel_for(int count, const std::function<void(int begin, int end)> &fn);
+
+private:
+	void worker_main(int index, unsigned int seen);
+	void stop();
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable finished;
+
+	const std::function<void(int, int)> *job = nullptr;
+	int job_count = 0;
+	unsigned int generation = 0;
+	int pending = 0;
+	bool stopping = false;
+};
@@ -1,5 +1,6 @@
 #include "world_init.hpp"
 #include "tinyECS/registry.hpp"
+#include "rope.hpp"
 #include <iostream>
 
 // Creates tracker component for current screen
@@ -44,11 +45,12 @@ Entity createScreenElement(std::string screen, TEXTURE_ASSET_ID texture, int wid
 	*/
 
 	// Add to render requests with specified texture
-	registry.renderRequests.insert(
+	RenderRequest &render_request = registry.renderRequests.insert(
 		entity,
 		{texture,
 		 EFFECT_ASSET_ID::TEXTURED,
 		 GEOMETRY_BUFFER_ID::SPRITE});
+	render_request.layer = RENDER_LAYER::SCREEN;
 
 	return entity;
 }
@@ -114,6 +116,7 @@ Entity createBall(b2WorldId worldId, vec2 startPos)
 	shapeDef.density = BALL_DENSTIY;
 	shapeDef.friction = BALL_FRICTION;
 	shapeDef.restitution = BALL_RESTITUTION;
+	shapeDef.filter = collision_filter(CATEGORY_PLAYER);
 	b2Circle circle;
 	circle.center = b2Vec2{0.0f, 0.0f};
 	circle.radius = BALL_RADIUS;
@@ -136,17 +139,18 @@ Entity createBall(b2WorldId worldId, vec2 startPos)
 	{
 		Entity ballVisualEntity = Entity();
 
+		RENDER_LAYER render_layer;
 		if (layer == "front")
 		{
-			registry.playerTopLayer.emplace(ballVisualEntity);
+			render_layer = RENDER_LAYER::PLAYER_TOP;
 		}
 		else if (layer == "middle")
 		{
-			registry.playerMidLayer.emplace(ballVisualEntity);
+			render_layer = RENDER_LAYER::PLAYER_MID;
 		}
 		else
 		{
-			registry.playerBottomLayer.emplace(ballVisualEntity);
+			render_layer = RENDER_LAYER::PLAYER_BACK;
 		}
 
 		auto &m = registry.motions.emplace(ballVisualEntity);
@@ -156,11 +160,12 @@ Entity createBall(b2WorldId worldId, vec2 startPos)
 
 		registry.playerRotatableLayers.emplace(ballVisualEntity);
 
-		registry.renderRequests.insert(
+		RenderRequest &render_request = registry.renderRequests.insert(
 			ballVisualEntity,
 			{textureId,
 			 effectId,
 			 GEOMETRY_BUFFER_ID::SPRITE});
+		render_request.layer = render_layer;
 	};
 
 	auto createRamsterRunLayer = [&]()
@@ -172,7 +177,6 @@ Entity createBall(b2WorldId worldId, vec2 startPos)
 		m.position = startPos;
 		m.scale = vec2(2 * circle.radius, 2 * circle.radius);
 
-		registry.playerMidLayer.emplace(ramsterVisualEntity);
 		registry.playerNonRotatableLayers.emplace(ramsterVisualEntity);
 		registry.runAnimations.emplace(ramsterVisualEntity);
 
@@ -188,7 +192,7 @@ Entity createBall(b2WorldId worldId, vec2 startPos)
 			TEXTURE_ASSET_ID::RAMSTER_RUN_7,
 		};
 
-		registry.renderRequests.insert(
+		RenderRequest &render_request = registry.renderRequests.insert(
 			ramsterVisualEntity,
 			{frames[0],
 			 EFFECT_ASSET_ID::RAMSTER,
@@ -200,6 +204,7 @@ Entity createBall(b2WorldId worldId, vec2 startPos)
 			 100.0f,
 			 0.0f,
 			 0});
+		render_request.layer = RENDER_LAYER::PLAYER_MID;
 	};
 
 	auto createRamsterIdleLayer = [&]()
@@ -211,7 +216,6 @@ Entity createBall(b2WorldId worldId, vec2 startPos)
 		m.position = startPos;
 		m.scale = vec2(2 * circle.radius, 2 * circle.radius);
 
-		registry.playerMidLayer.emplace(ramsterVisualEntity);
 		registry.playerNonRotatableLayers.emplace(ramsterVisualEntity);
 		registry.idleAnimations.emplace(ramsterVisualEntity);
 
@@ -225,7 +229,7 @@ Entity createBall(b2WorldId worldId, vec2 startPos)
 			TEXTURE_ASSET_ID::RAMSTER_IDLE_5,
 		};
 
-		registry.renderRequests.insert(
+		RenderRequest &render_request = registry.renderRequests.insert(
 			ramsterVisualEntity,
 			{frames[0],
 			 EFFECT_ASSET_ID::RAMSTER,
@@ -237,6 +241,7 @@ Entity createBall(b2WorldId worldId, vec2 startPos)
 			 200.0f,
 			 0.0f,
 			 0});
+		render_request.layer = RENDER_LAYER::PLAYER_MID;
 	};
 
 	// ========================================================================================================
@@ -379,7 +384,7 @@ Entity createFireball(vec2 startPos)
 		TEXTURE_ASSET_ID::FIREBALL_10,
 		TEXTURE_ASSET_ID::FIREBALL_11};
 
-	registry.renderRequests.insert(
+	RenderRequest &render_request = registry.renderRequests.insert(
 		entity,
 		{frames[0],
 		 EFFECT_ASSET_ID::FIREBALL,
@@ -391,6 +396,7 @@ Entity createFireball(vec2 startPos)
 		 60.0f,
 		 0.0f,
 		 0});
+	render_request.layer = RENDER_LAYER::FIREBALLS;
 
 	return entity;
 }
@@ -467,6 +473,8 @@ Entity createEnemy(b2WorldId worldID, vec2 pos, ENEMY_TYPES enemy_type, vec2 mov
 	enemy.movement_area_point_a = movement_range_point_a;
 	enemy.movement_area_point_b = movement_range_point_b;
 	enemy.destructable = destructability;
+	// spread MID enemies over the ticks by spawn order, so it doesn't depend on entity ids
+	enemy.ai_lod_phase = (int)(enemy_registry.size() - 1) % AI_LOD_MID_INTERVAL;
 
 	// Make Box2D body for enemy
 
@@ -483,8 +491,7 @@ Entity createEnemy(b2WorldId worldID, vec2 pos, ENEMY_TYPES enemy_type, vec2 mov
 	shapeDef.density = enemyWeight;
 	shapeDef.friction = enemyFriction;
 	shapeDef.restitution = enemyBounciness;
-
-	std::cout << "shape: " << shapeDef.filter.maskBits << std::endl;
+	shapeDef.filter = collision_filter(enemy_collision_category(enemy_type));
 
 	// Use `b2CreateCircleShape()` instead of `CreateFixture()`
 	// We'll update the enemy hitbox later.
@@ -539,6 +546,21 @@ Entity createEnemy(b2WorldId worldID, vec2 pos, ENEMY_TYPES enemy_type, vec2 mov
 	return entity;
 }
 
+void createEnemyGroup(b2WorldId worldId, ENEMY_TYPES enemy_type, int quantity, ivec2 gridPosition, ivec2 grid_patrol_point_a, ivec2 grid_patrol_point_b)
+{
+	// Create specified number of enemies by iterating
+	for (int i = 0; i < quantity; i++)
+	{
+		createEnemy(
+			worldId,
+			vec2((gridPosition.x + 0.5 + 0.05 * i) * GRID_CELL_WIDTH_PX,
+				 (gridPosition.y + 0.5) * GRID_CELL_HEIGHT_PX),
+			enemy_type,
+			vec2((grid_patrol_point_a.x + 0.5) * GRID_CELL_WIDTH_PX, (grid_patrol_point_a.y + 0.5) * GRID_CELL_HEIGHT_PX),
+			vec2((grid_patrol_point_b.x + 0.5) * GRID_CELL_WIDTH_PX, (grid_patrol_point_b.y + 0.5) * GRID_CELL_HEIGHT_PX));
+	}
+}
+
 // Entity createGrapplePoint(b2WorldId worldId){
 Entity createGrapplePoint(b2WorldId worldId, vec2 position)
 {
@@ -553,7 +575,7 @@ Entity createGrapplePoint(b2WorldId worldId, vec2 position)
 	b2ShapeDef shapeDef = b2DefaultShapeDef();
 
 	// Disable collisions
-	shapeDef.filter.maskBits = 0x0000;
+	shapeDef.filter = collision_filter(CATEGORY_SENSOR);
 	shapeDef.isSensor = true;
 
 	b2Circle circle;
@@ -598,35 +620,157 @@ Entity createGrapplePoint(b2WorldId worldId, vec2 position)
 	return entity;
 }
 
-Entity createGrapple(b2WorldId worldId, b2BodyId ballBodyId, b2BodyId grappleBodyId, float distance)
+// Grapple anchors are shapeless static bodies, each permanently jointed to the ball.
+// A free anchor is disabled (which also takes its joint out of the solver); attaching
+// moves it to the hit point and re-enables it, so grappling creates no new bodies.
+struct GrappleAnchor
 {
-	Entity entity = Entity();
+	b2BodyId bodyId;
+	b2JointId jointId;
+	bool inUse;
+};
+
+static std::vector<GrappleAnchor> grapple_pool;
+static b2BodyId grapple_pool_ball = b2_nullBodyId;
+static GrapplePoolStats grapple_pool_stats;
 
-	// Create distance joint between ball and grapple Point
+static GrappleAnchor createGrappleAnchor(b2WorldId worldId, b2BodyId ballBodyId)
+{
+	b2BodyDef bodyDef = b2DefaultBodyDef();
+	bodyDef.type = b2_staticBody;
+	bodyDef.isEnabled = false;
+	b2BodyId bodyId = b2CreateBody(worldId, &bodyDef);
+
+	// Create distance joint between ball and anchor
 	b2DistanceJointDef djd = b2DefaultDistanceJointDef();
 	djd.bodyIdA = ballBodyId;
-	djd.bodyIdB = grappleBodyId;
-
-	djd.length = distance;
+	djd.bodyIdB = bodyId;
+	djd.length = GRAPPLE_MAX_LENGTH;
 	djd.collideConnected = false;
-	// djd.maxLength = GRAPPLE_ATTACHABLE_RADIUS;
 	djd.maxLength = GRAPPLE_MAX_LENGTH;
 	djd.minLength = GRAPPLE_MIN_LENGTH;
 
-	b2JointId jointId = b2CreateDistanceJoint(worldId, &djd);
+	GrappleAnchor anchor;
+	anchor.bodyId = bodyId;
+	anchor.jointId = b2CreateDistanceJoint(worldId, &djd);
+	anchor.inUse = false;
+
+	grapple_pool_stats.capacity++;
+	return anchor;
+}
+
+static GrappleAnchor &acquireGrappleAnchor(b2WorldId worldId, b2BodyId ballBodyId)
+{
+	// joints are tied to the ball, so a new ball (level restart) needs a new pool
+	if (!B2_ID_EQUALS(grapple_pool_ball, ballBodyId))
+	{
+		resetGrapplePool();
+		grapple_pool_ball = ballBodyId;
+		for (int i = 0; i < GRAPPLE_POOL_SIZE; i++)
+		{
+			grapple_pool.push_back(createGrappleAnchor(worldId, ballBodyId));
+		}
+	}
+
+	grapple_pool_stats.acquires++;
+	for (GrappleAnchor &anchor : grapple_pool)
+	{
+		if (!anchor.inUse)
+		{
+			return anchor;
+		}
+	}
+
+	grapple_pool_stats.allocations++;
+	grapple_pool.push_back(createGrappleAnchor(worldId, ballBodyId));
+	return grapple_pool.back();
+}
+
+static void releaseGrappleAnchor(b2BodyId bodyId)
+{
+	for (GrappleAnchor &anchor : grapple_pool)
+	{
+		if (anchor.inUse && B2_ID_EQUALS(anchor.bodyId, bodyId))
+		{
+			b2Body_Disable(anchor.bodyId);
+			anchor.inUse = false;
+			grapple_pool_stats.inUse--;
+			return;
+		}
+	}
+}
+
+void resetGrapplePool()
+{
+	if (!grapple_pool.empty())
+	{
+		std::cout << "Grapple pool: " << grapple_pool_stats.acquires << " attaches, "
+				  << grapple_pool_stats.capacity << " anchors, peak " << grapple_pool_stats.peakInUse
+				  << " in use, " << grapple_pool_stats.allocations << " grown" << std::endl;
+	}
+
+	// destroying an anchor also destroys its joint
+	for (GrappleAnchor &anchor : grapple_pool)
+	{
+		if (b2Body_IsValid(anchor.bodyId))
+		{
+			b2DestroyBody(anchor.bodyId);
+		}
+	}
+	grapple_pool.clear();
+	grapple_pool_ball = b2_nullBodyId;
+	grapple_pool_stats = GrapplePoolStats();
+}
+
+GrapplePoolStats getGrapplePoolStats()
+{
+	return grapple_pool_stats;
+}
+
+Entity createGrapple(b2WorldId worldId, b2BodyId ballBodyId, vec2 anchorPosition, float distance)
+{
+	Entity entity = Entity();
+
+	GrappleAnchor &anchor = acquireGrappleAnchor(worldId, ballBodyId);
+	anchor.inUse = true;
+	grapple_pool_stats.inUse++;
+	grapple_pool_stats.peakInUse = std::max(grapple_pool_stats.peakInUse, grapple_pool_stats.inUse);
+
+	// move the anchor while it is still disabled, then put it (and its joint) back in the world
+	b2Body_SetTransform(anchor.bodyId, b2Vec2{anchorPosition.x, anchorPosition.y}, b2Rot_identity);
+	b2Body_Enable(anchor.bodyId);
+
+	// undo whatever checkGrappleGrounded() did to this joint last time
+	b2JointId jointId = anchor.jointId;
+	b2DistanceJoint_EnableSpring(jointId, false);
+	b2DistanceJoint_SetSpringHertz(jointId, 0.0f);
+	b2DistanceJoint_SetSpringDampingRatio(jointId, 0.0f);
+	b2DistanceJoint_EnableLimit(jointId, false);
+	b2DistanceJoint_SetLengthRange(jointId, GRAPPLE_MIN_LENGTH, GRAPPLE_MAX_LENGTH);
+	b2DistanceJoint_SetLength(jointId, distance);
 
 	// Store grapple data
 	Grapple &grapple = registry.grapples.emplace(entity);
 	grapple.jointId = jointId;
 	grapple.ballBodyId = ballBodyId;
-	grapple.grappleBodyId = grappleBodyId;
+	grapple.grappleBodyId = anchor.bodyId;
 
 	// Create line entity to visualize grapple
 	b2Vec2 ballPos = b2Body_GetPosition(ballBodyId);
-	b2Vec2 grapplePos = b2Body_GetPosition(grappleBodyId);
+	b2Vec2 grapplePos = b2Body_GetPosition(anchor.bodyId);
 
-	Entity lineEntity = createLine(vec2(ballPos.x, ballPos.y), vec2(grapplePos.x, grapplePos.y));
-	grapple.lineEntity = lineEntity; // Store the line entity for updates
+	if (GRAPPLE_ROPE_MODE)
+	{
+		// the rope lives on the grapple entity and is drawn instead of the line
+		Rope &rope = registry.ropes.emplace(entity);
+		rope_init(rope, vec2(ballPos.x, ballPos.y), vec2(grapplePos.x, grapplePos.y), GRAPPLE_ROPE_SEGMENTS);
+		grapple.lineEntity = entity;
+	}
+	else
+	{
+		Entity lineEntity = createLine(vec2(ballPos.x, ballPos.y), vec2(grapplePos.x, grapplePos.y));
+		grapple.lineEntity = lineEntity; // Store the line entity for updates
+	}
 
 	return entity;
 }
@@ -636,7 +780,11 @@ void removeGrapple()
 	for (Entity &grapple_entity : registry.grapples.entities)
 	{
 		Grapple &grapple = registry.grapples.get(grapple_entity);
-		b2DestroyJoint(grapple.jointId);
+		releaseGrappleAnchor(grapple.grappleBodyId);
+		if (registry.ropes.has(grapple_entity) && registry.ropes.get(grapple_entity).budget_overruns > 0)
+		{
+			std::cout << "Grapple rope went over budget on " << registry.ropes.get(grapple_entity).budget_overruns << " frames" << std::endl;
+		}
 		registry.remove_all_components_of(grapple_entity);
 
 		if (registry.lines.has(grapple.lineEntity))
@@ -657,11 +805,12 @@ Entity createGridLine(vec2 start_pos, vec2 end_pos)
 	gridLine.start_pos = start_pos;
 	gridLine.end_pos = start_pos + end_pos;
 
-	registry.renderRequests.insert(
+	RenderRequest &render_request = registry.renderRequests.insert(
 		entity,
 		{TEXTURE_ASSET_ID::TEXTURE_COUNT,
 		 EFFECT_ASSET_ID::LEGACY_EGG,
 		 GEOMETRY_BUFFER_ID::DEBUG_LINE});
+	render_request.layer = RENDER_LAYER::GRID;
 
 	registry.colors.insert(entity, vec3(0.0f, 1.0f, 0.0f));
 	return entity;
@@ -678,11 +827,12 @@ Entity createLine(vec2 start_pos, vec2 end_pos)
 	line.start_pos = start_pos;
 	line.end_pos = end_pos;
 
-	registry.renderRequests.insert(
+	RenderRequest &render_request = registry.renderRequests.insert(
 		entity,
 		{TEXTURE_ASSET_ID::TEXTURE_COUNT,
 		 EFFECT_ASSET_ID::LEGACY_EGG,
 		 GEOMETRY_BUFFER_ID::DEBUG_LINE});
+	render_request.layer = RENDER_LAYER::LINES;
 
 	registry.colors.insert(entity, vec3(1.0f, 1.0f, 1.0f));
 	return entity;
@@ -695,19 +845,18 @@ Entity createHealthBar(float health)
 	HealthBar &hp = registry.healthbars.emplace(entity);
 	hp.health = health;
 
-	registry.uis.emplace(entity);
-
 	auto &motion = registry.motions.emplace(entity);
 	motion.position = vec2(150, WINDOW_HEIGHT_PX - 50);
 	motion.scale = vec2(200, 20);
 
 	registry.colors.emplace(entity) = vec3(0.2f, 0.9f, 0.2f);
 
-	registry.renderRequests.insert(
+	RenderRequest &render_request = registry.renderRequests.insert(
 		entity,
 		{TEXTURE_ASSET_ID::TEXTURE_COUNT,  // No texture
 		 EFFECT_ASSET_ID::LEGACY_EGG,	   // Uses colored shader
 		 GEOMETRY_BUFFER_ID::DEBUG_LINE}); // Use existing filled shape geometry
+	render_request.layer = RENDER_LAYER::UI;
 
 	return entity;
 }
@@ -724,11 +873,12 @@ Entity createLevelTextureLayer(TEXTURE_ASSET_ID textureId)
 	motion.position = vec2(WORLD_WIDTH_PX / 2, WORLD_HEIGHT_PX / 2);
 	motion.scale = vec2(WORLD_WIDTH_PX, WORLD_HEIGHT_PX);
 
-	registry.renderRequests.insert(
+	RenderRequest &render_request = registry.renderRequests.insert(
 		entity,
 		{textureId,
 		 EFFECT_ASSET_ID::TEXTURED,
 		 GEOMETRY_BUFFER_ID::SPRITE});
+	render_request.layer = RENDER_LAYER::LEVEL;
 
 	return entity;
 }
@@ -757,7 +907,7 @@ Entity createBackgroundLayer()
 		TEXTURE_ASSET_ID::BACKGROUND_7,
 	};
 
-	registry.renderRequests.insert(
+	RenderRequest &render_request = registry.renderRequests.insert(
 		entity,
 		{frames[0],
 		 EFFECT_ASSET_ID::PARALLAX,
@@ -769,6 +919,7 @@ Entity createBackgroundLayer()
 		 300.0f,
 		 0.0f,
 		 0});
+	render_request.layer = RENDER_LAYER::BACKGROUND;
 
 	return entity;
 }
@@ -795,8 +946,6 @@ Entity createScore()
 	Score &score = registry.scores.emplace(scoreEntity);
 	score.score = 0;
 
-	registry.uis.emplace(scoreEntity);
-
 	vec2 basePosition = vec2(150, WINDOW_HEIGHT_PX - 50);
 	vec2 digitSize = vec2(30, 40);
 
@@ -809,14 +958,13 @@ Entity createScore()
 		motion.position = basePosition + offset;
 		motion.scale = digitSize;
 
-		registry.uis.emplace(digitEntity);
-
 		// Start all digits at 0
-		registry.renderRequests.insert(
+		RenderRequest &render_request = registry.renderRequests.insert(
 			digitEntity,
 			{TEXTURE_ASSET_ID::NUMBER_0,
 			 EFFECT_ASSET_ID::TEXTURED,
 			 GEOMETRY_BUFFER_ID::SPRITE});
+		render_request.layer = RENDER_LAYER::UI;
 
 		// Track this digit in the Score component
 		score.digits[i] = digitEntity;
@@ -830,8 +978,6 @@ Entity createTimer()
 	Entity timerEntity = Entity();
 	Timer &timer = registry.timers.emplace(timerEntity);
 
-	registry.uis.emplace(timerEntity);
-
 	vec2 basePosition = vec2(150, WINDOW_HEIGHT_PX - 50);
 	vec2 digitSize = vec2(30, 40);
 
@@ -845,24 +991,24 @@ Entity createTimer()
 		motion.position = basePosition + offset;
 		motion.scale = digitSize;
 
-		registry.uis.emplace(digitEntity);
-
 		// Render
 		if (i == 2 || i == 5)
 		{
-			registry.renderRequests.insert(
+			RenderRequest &render_request = registry.renderRequests.insert(
 				digitEntity,
 				{TEXTURE_ASSET_ID::COLON,
 				 EFFECT_ASSET_ID::TEXTURED,
 				 GEOMETRY_BUFFER_ID::SPRITE});
+			render_request.layer = RENDER_LAYER::UI;
 		}
 		else
 		{
-			registry.renderRequests.insert(
+			RenderRequest &render_request = registry.renderRequests.insert(
 				digitEntity,
 				{TEXTURE_ASSET_ID::NUMBER_0,
 				 EFFECT_ASSET_ID::TEXTURED,
 				 GEOMETRY_BUFFER_ID::SPRITE});
+			render_request.layer = RENDER_LAYER::UI;
 		}
 		timer.digits[i] = digitEntity;
 	}
@@ -39,6 +39,8 @@ Entity createStoryFrame(int frameNumber, int maxFrame, std::string screen, TEXTU
 
 // enemy
 Entity createEnemy(b2WorldId worldID, vec2 pos, ENEMY_TYPES enemy_type, vec2 movement_range_point_a, vec2 movement_range_point_b);
+// a level spawn: quantity enemies in one grid cell (patrol points are grid cells too, obstacles only)
+void createEnemyGroup(b2WorldId worldId, ENEMY_TYPES enemy_type, int quantity, ivec2 gridPosition, ivec2 grid_patrol_point_a, ivec2 grid_patrol_point_b);
 
 // invaders
 Entity createInvader(RenderSystem *renderer, vec2 position);
@@ -62,10 +64,23 @@ Entity createLine(vec2 start_pos, vec2 end_pos);
 // grapple point (andrew version)
 Entity createGrapplePoint(b2WorldId worldId, vec2 position);
 
-// grapple hook
-Entity createGrapple(b2WorldId worldId, b2BodyId ballBodyId, b2BodyId grappleBodyId, float distance);
+// grapple hook (anchored with a pooled anchor body + distance joint)
+Entity createGrapple(b2WorldId worldId, b2BodyId ballBodyId, vec2 anchorPosition, float distance);
 void removeGrapple();
 
+// grapple anchor pool
+struct GrapplePoolStats
+{
+	int capacity = 0;	 // anchor bodies (and joints) owned by the pool
+	int inUse = 0;		 // anchors currently enabled
+	int peakInUse = 0;	 // highest inUse since the last reset
+	int acquires = 0;	 // total attaches served
+	int allocations = 0; // attaches that had to create a new body/joint
+};
+// destroys every pooled anchor; call before the ball body is destroyed
+void resetGrapplePool();
+GrapplePoolStats getGrapplePoolStats();
+
 Entity createGoalZone(vec2 bottom_left_pos, vec2 bottom_right_pos);
 
 // level layers
@@ -16,6 +16,8 @@
 // internal
 #include "physics_system.hpp"
 #include "terrain.hpp"
+#include "level_loader.hpp"
+#include "rng.hpp"
 
 static void framebuffer_size_callback(GLFWwindow *window, int width, int height)
 {
@@ -28,9 +30,6 @@ static void framebuffer_size_callback(GLFWwindow *window, int width, int height)
   }
 }
 
-// Global Variables
-bool grapplePointActive = false;
-bool grappleActive = false;
 // No longer need this - maps onto current level MUSIC current_music = MUSIC::LEVEL_1;
 
 // create the world
@@ -40,8 +39,8 @@ WorldSystem::WorldSystem(b2WorldId worldId) : enemies_killed(0),
                                               enemy_spawn_rate_ms(ENEMY_SPAWN_RATE_MS),
                                               worldId(worldId)
 {
-  // seeding rng with random device
-  rng = std::default_random_engine(std::random_device()());
+  // unlogged runs get a fresh seed; recordings and replays reseed in start_logged_level
+  rng_seed(rng_entropy_seed());
 
   // initialize key states with needed keys.
   for (int i = 0; i < PLAYER_CONTROL_KEYS.size(); i++)
@@ -130,13 +129,15 @@ GLFWwindow *WorldSystem::create_window()
   }
 
   //-------------------------------------------------------------------------
-  // If you are on Linux or Windows, you can change these 2 numbers to 4 and 3 and
-  // enable the glDebugMessageCallback to have OpenGL catch your mistakes for you.
   // GLFW / OGL Initialization
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifndef NDEBUG
+  // debug builds ask for a debug context so RenderSystem::initDebugOutput can install the
+  // KHR_debug callback; release builds skip the driver-side validation
   glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+#endif
 #if __APPLE__
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
@@ -352,24 +353,18 @@ void WorldSystem::handleRamsterVoicelines()
     return; // Cooldown period has not passed, do nothing
   }
 
-  // Random number generator for probability increase
-  std::random_device rd;
-  std::mt19937 gen(rd());
-  std::uniform_int_distribution<> dis(5, 15);
-
   // Increment the probability by a random percentage between 5 and 15
-  player.voicelineProbability += dis(gen);
+  player.voicelineProbability += rng_int(RNG_STREAM::COSMETIC, 5, 15);
 
   // Generate a random number between 0 and 100
-  std::uniform_int_distribution<> chance(0, 100);
-  int randomChance = chance(gen);
+  int randomChance = rng_int(RNG_STREAM::COSMETIC, 0, 100);
 
   // Check if the random chance is less than or equal to the current probability
   if (randomChance <= player.voicelineProbability)
   {
     // Play voiceline and reset the probability
     int channel;
-    int random = rand() % 2;
+    int random = rng_int(RNG_STREAM::COSMETIC, 0, 1);
 
     if (random == 0)
     {
@@ -481,6 +476,16 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
   // Updating window title with enemies_killed (and remaining towers)
   std::stringstream title_ss;
   title_ss << "Ramster | Level : " << current_level << " | Time : " << time_elapsed << "s | Kills : " << enemies_killed << " | HP : " << hp << " | FPS : " << fps;
+  // engine counters only in debug mode (P)
+  if (debugging.in_debug_mode)
+  {
+    b2Counters counters = b2World_GetCounters(worldId);
+    title_ss << " | Contacts : " << counters.contactCount
+             << " | AI near/mid/far : " << ai_lod_band_counts[AI_LOD_NEAR] << "/" << ai_lod_band_counts[AI_LOD_MID] << "/" << ai_lod_band_counts[AI_LOD_FAR]
+             << " | LOS rays : " << ai_los_rays_last_step << " (" << ai_los_queue_length << " queued)"
+             << " | Draws : " << renderer->stats.draw_calls << " | GL state calls : " << renderer->stats.gl_calls_issued << " (" << renderer->stats.gl_calls_skipped << " skipped)"
+             << " | Culled : " << renderer->stats.cull_culled << "/" << renderer->stats.cull_drawn + renderer->stats.cull_culled;
+  }
   glfwSetWindowTitle(window, title_ss.str().c_str());
 
   auto now = std::chrono::steady_clock::now();
@@ -537,6 +542,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
       update_isGrounded();
       handle_movement(elapsed_ms_since_last_update);
       checkGrappleGrounded();
+      updateTrajectoryPreview();
       handleRollingSfx();
       handleFlammingSfx();
     }
@@ -583,6 +589,119 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
   return game_active;
 }
 
+float WorldSystem::begin_frame(float elapsed_ms)
+{
+  if (input_log.mode() == InputLog::MODE::OFF || !game_active)
+  {
+    return elapsed_ms;
+  }
+
+  // only frames that actually simulate the level are ticks
+  Entity currScreenEntity = registry.currentScreen.entities[0];
+  CurrentScreen &currentScreen = registry.currentScreen.get(currScreenEntity);
+  if (currentScreen.current_screen != "PLAYING")
+  {
+    return elapsed_ms;
+  }
+
+  if (input_log.recording())
+  {
+    // this tick's clicks were already handled by on_mouse_button_pressed
+    poll_control_keys();
+    input_log.record_tick(elapsed_ms, world_checksum(), pack_control_keys(keyStates));
+    return elapsed_ms;
+  }
+
+  InputLog::Tick tick;
+  if (!input_log.next_tick(tick))
+  {
+    // end of the recording, the player takes over from here
+    input_log.stop();
+    return elapsed_ms;
+  }
+  for (vec2 click : tick.clicks)
+  {
+    handleGrappleClick(click);
+  }
+  input_log.verify(world_checksum());
+  unpack_control_keys(tick.keys, keyStates);
+  return tick.elapsed_ms;
+}
+
+bool WorldSystem::start_recording(const std::string &path, int level)
+{
+  InputLog::Header header;
+  header.level = level;
+  header.seed = rng_entropy_seed();
+  header.flags = (GRAPPLE_ROPE_MODE ? InputLog::FLAG_ROPE_MODE : 0) |
+                 (SWARM_SWARM_CONTACTS ? InputLog::FLAG_SWARM_SWARM_CONTACTS : 0);
+
+  if (!input_log.start_recording(path, header))
+  {
+    return false;
+  }
+  std::cout << "Recording level " << level << " to " << path << std::endl;
+  return start_logged_level(header);
+}
+
+bool WorldSystem::start_replay(const std::string &path)
+{
+  if (!input_log.start_replay(path))
+  {
+    return false;
+  }
+  const InputLog::Header &header = input_log.header();
+  GRAPPLE_ROPE_MODE = (header.flags & InputLog::FLAG_ROPE_MODE) != 0;
+  SWARM_SWARM_CONTACTS = (header.flags & InputLog::FLAG_SWARM_SWARM_CONTACTS) != 0;
+  std::cout << "Replaying level " << header.level << " from " << path << std::endl;
+  return start_logged_level(header);
+}
+
+bool WorldSystem::start_bench_level(int level)
+{
+  if (levelMap.find(level) == levelMap.end())
+  {
+    std::cerr << "ERROR: no level " << level << std::endl;
+    return false;
+  }
+
+  current_level = level;
+  Entity currScreenEntity = registry.currentScreen.entities[0];
+  registry.currentScreen.get(currScreenEntity).current_screen = "PLAYING";
+  restart_game(current_level);
+
+  // the camera visits the whole level, so everything is spawned up front instead of by trigger
+  for (auto &i : spawnMap)
+  {
+    auto &[enemyType, quantity, hasPlayerReachedTile, hasEnemyAlreadySpawned, spawnPosition, patrolRange] = i.second;
+    hasPlayerReachedTile = true;
+    hasEnemyAlreadySpawned = true;
+    handleEnemySpawning(enemyType, quantity,
+                        ivec2(spawnPosition[0], spawnPosition[1]),
+                        ivec2(patrolRange[0], patrolRange[1]),
+                        ivec2(patrolRange[2], patrolRange[3]));
+  }
+  return true;
+}
+
+// Both sides of a replay start the same way: seed, then load the level directly (no menus or story screens).
+bool WorldSystem::start_logged_level(const InputLog::Header &header)
+{
+  if (levelMap.find(header.level) == levelMap.end())
+  {
+    std::cerr << "ERROR: no level " << header.level << std::endl;
+    input_log.stop();
+    return false;
+  }
+
+  rng_seed(header.seed);
+  current_level = header.level;
+  Entity currScreenEntity = registry.currentScreen.entities[0];
+  registry.currentScreen.get(currScreenEntity).current_screen = "PLAYING";
+  restart_game(current_level);
+  return true;
+}
+
 void WorldSystem::stop_game()
 {
   // disable player input (except 'R' for restart), see on_key
@@ -647,336 +766,17 @@ bool WorldSystem::is_in_goal()
 
 bool WorldSystem::load_level(const std::string &filename)
 {
-  const std::string full_filepath = LEVEL_DIR_FILEPATH + filename;
-  Json::Value mapData;
+  // parsing (and the ball/goal/terrain it creates) lives in level_loader.cpp so headless tools can share it
+  std::vector<LevelSpawn> spawns;
+  bool loaded = load_level_file(filename, worldId, spawns);
 
-  std::ifstream infile(full_filepath);
-
-  if (infile.fail())
+  for (const LevelSpawn &spawn : spawns)
   {
-    return false;
+    insertToSpawnMap(spawn.trigger_bottom_left, spawn.trigger_top_right, spawn.enemy_type, spawn.quantity,
+                     spawn.spawn_location, spawn.patrol_point_a, spawn.patrol_point_b);
   }
 
-  infile >> mapData;
-
-  // checks to ensure JSON data is the expected format.
-  assert(mapData.find("height") != nullptr);
-  assert(mapData.find("width") != nullptr);
-  assert(mapData.find("layers") != nullptr);
-  assert(mapData["layers"].size() >= 2);
-  assert(mapData["layers"][1]["name"] == "Chain"); // this assert fails if map doesn't have at least 1 chainShape.
-  assert(mapData["layers"][1].find("objects") != nullptr);
-
-  // set stage dimensions
-  WORLD_WIDTH_TILES = mapData["width"].asFloat() / 2;
-  WORLD_HEIGHT_TILES = mapData["height"].asFloat() / 2;
-
-  WORLD_WIDTH_PX = WORLD_WIDTH_TILES * GRID_CELL_WIDTH_PX;
-  WORLD_HEIGHT_PX = WORLD_HEIGHT_TILES * GRID_CELL_HEIGHT_PX;
-
-  auto &JsonObjects = mapData["layers"][1]["objects"];
-  bool spawnpoint_found = false;
-  bool goalzone_found = false;
-
-  // Temporary storage for spawn zones and points
-  std::unordered_map<std::string, std::vector<vec2>> spawnZones;
-  std::unordered_map<std::string, std::vector<vec2>> spawnPoints;
-  std::unordered_map<std::string, std::string> enemyType;
-  std::unordered_map<std::string, int> enemyQuantity;
-
-  for (const auto &jsonObj : JsonObjects)
-  {
-    // polyline case
-    if (jsonObj.find(JSON_POLYLINE_ATTR) != nullptr)
-    {
-      std::vector<vec2> chainPoints;
-      const float x_offset = jsonObj["x"].asFloat();
-      const float y_offset = jsonObj["y"].asFloat();
-      const float rotation = jsonObj["rotation"].asFloat() * (M_PI / 180.f);
-
-      for (auto &point : jsonObj[JSON_POLYLINE_ATTR])
-      {
-        float x = point["x"].asFloat();
-        float y = point["y"].asFloat();
-
-        // rotate points
-        if (rotation != 0.f)
-        {
-          vec2 origin = vec2(0.f, 0.f);
-          vec2 rotatedPoint = rotateAroundPoint(vec2(x, y), origin, rotation);
-          x = rotatedPoint.x;
-          y = rotatedPoint.y;
-        }
-
-        chainPoints.push_back(vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset)));
-      }
-
-      std::string name = jsonObj["name"].asString();
-      if (chainPoints.size() == 2 && name.find("SZ") == 0)
-      {
-        // Process enemy spawn zone
-        std::vector<std::string> parts = split(name, "_");
-        if (parts.size() == 2)
-        {
-          std::string id = parts[1];
-          spawnZones[id] = chainPoints;
-          std::cout << "Found enemy spawn ZONE with id: " << id << std::endl;
-        }
-      }
-      else if (chainPoints.size() == 2 && name.find("ENEMY") == 0)
-      {
-        std::cout << "found obstacle enemy spawnpath." << std::endl;
-        std::vector<std::string> parts = split(name, "_");
-        std::vector<vec2> points;
-        std::string id = parts[3];
-
-        const float x_offset = jsonObj["x"].asFloat();
-        const float y_offset = jsonObj["y"].asFloat();
-
-        for (auto &point : jsonObj[JSON_POLYLINE_ATTR])
-        {
-          float x = point["x"].asFloat();
-          float y = point["y"].asFloat();
-          points.push_back(vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset)));
-        }
-
-        spawnPoints[id] = points;
-        enemyType[id] = parts[1];
-        enemyQuantity[id] = std::stoi(parts[2]);
-      }
-      else if (chainPoints.size() == 2 && name == "goal")
-      {
-        std::cout << "found goalpost!" << std::endl;
-        goalzone_found = true;
-
-        bool first = true;
-        vec2 bl_corner;
-        vec2 tr_corner;
-        for (auto &point : jsonObj[JSON_POLYLINE_ATTR])
-        {
-          float x = point["x"].asFloat();
-          float y = point["y"].asFloat();
-
-          if (first)
-          {
-            bl_corner = vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset));
-            first = false;
-          }
-          else
-          {
-            tr_corner = vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset));
-          }
-        }
-
-        createGoalZone(bl_corner, tr_corner);
-      }
-      else if (chainPoints.size() >= 2)
-      {
-        std::cout << "Creating chainShape with " << chainPoints.size() << " segments." << std::endl;
-        if (name == "ledge")
-        {
-          create_chain(worldId, chainPoints, false, lines);
-        }
-        else
-        {
-          create_chain(worldId, chainPoints, true, lines);
-        }
-      }
-    }
-    // polygon case: polygon = closed-loop chain
-    else if (jsonObj.find(JSON_POLYGON_ATTR) != nullptr)
-    {
-      std::vector<vec2> chainPoints;
-      const float x_offset = jsonObj["x"].asFloat();
-      const float y_offset = jsonObj["y"].asFloat();
-      const float rotation = jsonObj["rotation"].asFloat() * (M_PI / 180.f);
-
-      for (auto &point : jsonObj[JSON_POLYGON_ATTR])
-      {
-        float x = point["x"].asFloat();
-        float y = point["y"].asFloat();
-
-        // rotate enemies_killed
-        if (rotation != 0.f)
-        {
-          vec2 origin = vec2(0.f, 0.f);
-          vec2 rotatedPoint = rotateAroundPoint(vec2(x, y), origin, rotation);
-          x = rotatedPoint.x;
-          y = rotatedPoint.y;
-        }
-
-        chainPoints.push_back(vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset)));
-      }
-
-      std::string name = jsonObj["name"].asString();
-      if (chainPoints.size() == 2 && name.find("SZ") == 0)
-      {
-        // Process enemy spawn zone
-        std::vector<std::string> parts = split(name, "_");
-        if (parts.size() == 2)
-        {
-          std::string id = parts[1];
-          spawnZones[id] = chainPoints;
-          std::cout << "Found enemy spawn ZONE with id: " << id << std::endl;
-        }
-      }
-      else if (chainPoints.size() == 2 && name.find("ENEMY") == 0)
-      {
-        std::cout << "found obstacle enemy spawnpath." << std::endl;
-        std::vector<std::string> parts = split(name, "_");
-        std::vector<vec2> points;
-        std::string id = parts[3];
-
-        const float x_offset = jsonObj["x"].asFloat();
-        const float y_offset = jsonObj["y"].asFloat();
-
-        for (auto &point : jsonObj[JSON_POLYLINE_ATTR])
-        {
-          float x = point["x"].asFloat();
-          float y = point["y"].asFloat();
-          points.push_back(vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset)));
-        }
-
-        spawnPoints[id] = points;
-        enemyType[id] = parts[1];
-        enemyQuantity[id] = std::stoi(parts[2]);
-      }
-      else if (chainPoints.size() == 2 && name == "goal")
-      {
-        std::cout << "found goalpost!" << std::endl;
-        goalzone_found = true;
-
-        bool first = true;
-        vec2 bl_corner;
-        vec2 tr_corner;
-        for (auto &point : jsonObj[JSON_POLYLINE_ATTR])
-        {
-          float x = point["x"].asFloat();
-          float y = point["y"].asFloat();
-
-          if (first)
-          {
-            bl_corner = vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset));
-            first = false;
-          }
-          else
-          {
-            tr_corner = vec2(x + x_offset, WORLD_HEIGHT_PX - (y + y_offset));
-          }
-        }
-
-        createGoalZone(bl_corner, tr_corner);
-      }
-      else if (chainPoints.size() >= 2)
-      {
-        std::cout << "Creating chainShape with " << chainPoints.size() << " segments." << std::endl;
-        if (name == "ledge")
-        {
-          create_chain(worldId, chainPoints, false, lines);
-        }
-        else
-        {
-          create_chain(worldId, chainPoints, true, lines);
-        }
-      }
-    }
-    // ball_spawnpoint case
-    else if (jsonObj.find("name") != nullptr && jsonObj["name"] == JSON_BALL_SPAWNPOINT)
-    {
-      const float x = jsonObj["x"].asFloat();
-      const float y = jsonObj["y"].asFloat();
-      createBall(worldId, vec2(x, WORLD_HEIGHT_PX - y));
-      spawnpoint_found = true;
-    }
-
-    // enemy spawnpoint case
-    else if (jsonObj.find("name") != nullptr && jsonObj["name"].asString().find("ENEMY") == 0)
-    {
-      std::string name = jsonObj["name"].asString();
-      std::vector<std::string> parts = split(name, "_");
-      if (parts.size() == 4)
-      {
-        std::string id = parts[3];
-        std::vector<vec2> points;
-
-        float x = jsonObj["x"].asFloat();
-        float y = jsonObj["y"].asFloat();
-        points.push_back(vec2(x, WORLD_HEIGHT_PX - y));
-
-        std::cout << "Found enemy spawn POINT with id: " << id << std::endl;
-        spawnPoints[id] = points;
-        enemyType[id] = parts[1];
-        enemyQuantity[id] = std::stoi(parts[2]);
-      }
-    }
-    // grapple point case
-    else if (jsonObj.find("name") != nullptr && jsonObj["name"] == "grapple_point")
-    {
-      const float x = jsonObj["x"].asFloat();
-      const float y = jsonObj["y"].asFloat();
-
-      std::cout << "Found grapple point at: " << x << ", " << y << std::endl;
-      createGrapplePoint(worldId, vec2(x, WORLD_HEIGHT_PX - y));
-    }
-  }
-
-  // Process enemy spawns
-  for (const auto &[id, zone] : spawnZones)
-  {
-    if (spawnPoints.find(id) != spawnPoints.end())
-    {
-      std::vector<vec2> points = spawnPoints[id];
-      ENEMY_TYPES currEnemyType;
-
-      switch (enemyType[id][0])
-      {
-      case 'S':
-        currEnemyType = SWARM;
-        break;
-      case 'C':
-        currEnemyType = COMMON;
-        break;
-      case 'O':
-        currEnemyType = OBSTACLE;
-        break;
-      }
-
-      int quantity = enemyQuantity[id];
-
-      ivec2 bottom_left = ivec2(zone[0].x / TILE_WIDTH, zone[0].y / TILE_HEIGHT);
-      ivec2 top_right = ivec2(zone[1].x / TILE_WIDTH, zone[1].y / TILE_HEIGHT);
-
-      if (currEnemyType == OBSTACLE && points.size() == 2)
-      {
-        vec2 start = points[0];
-        vec2 end = points[1];
-        ivec2 spawn_location = ivec2(start.x / TILE_WIDTH, start.y / TILE_HEIGHT);
-        ivec2 obstacle_patrol_bottom_left = ivec2(start.x / TILE_WIDTH, start.y / TILE_HEIGHT);
-        ivec2 obstacle_patrol_top_right = ivec2(end.x / TILE_WIDTH, end.y / TILE_HEIGHT);
-        insertToSpawnMap(bottom_left, top_right, currEnemyType, quantity, spawn_location, obstacle_patrol_bottom_left, obstacle_patrol_top_right);
-      }
-      else if (points.size() == 1)
-      {
-        vec2 point = points[0];
-        ivec2 spawn_location = ivec2(point.x / TILE_WIDTH, point.y / TILE_HEIGHT);
-        insertToSpawnMap(bottom_left, top_right, currEnemyType, quantity, spawn_location, ivec2(0, 0), ivec2(0, 0));
-      }
-    }
-  }
-
-  if (!spawnpoint_found)
-  {
-    std::cerr << "No spawnpoint found in map file." << std::endl;
-    return false;
-  }
-
-  if (!goalzone_found)
-  {
-    std::cerr << "No goalzone found in map file." << std::endl;
-    return false;
-  }
-
-  return true;
+  return loaded;
 }
 
 // Reset the world state to its initial state
@@ -1014,12 +814,25 @@ void WorldSystem::restart_game(int level)
   is_paused = false;
   first_goal = false;
   final_time = 0;
+  jump_cooldown_timer = 0.0f;
+  for (int key : PLAYER_CONTROL_KEYS)
+  {
+    keyStates[key] = false;
+  }
+
+  // a recording or replay covers one run of one level, from its start
+  if (input_log.mode() != InputLog::MODE::OFF && input_log.tick_count() > 0)
+  {
+    input_log.stop();
+  }
   if (grapplePointActive || grappleActive)
   {
     removeGrapple();
     grappleActive = false;
     grapplePointActive = false;
   }
+  // anchors are jointed to the old ball, drop them before the bodies go
+  resetGrapplePool();
 
   // remove all box2d bodies
   while (registry.physicsBodies.entities.size() > 0)
@@ -1080,21 +893,6 @@ void WorldSystem::restart_game(int level)
     registry.playerNonRotatableLayers.remove(registry.playerNonRotatableLayers.entities.back());
   }
 
-  while (registry.playerTopLayer.entities.size() > 0)
-  {
-    registry.playerTopLayer.remove(registry.playerTopLayer.entities.back());
-  }
-
-  while (registry.playerMidLayer.entities.size() > 0)
-  {
-    registry.playerMidLayer.remove(registry.playerMidLayer.entities.back());
-  }
-
-  while (registry.playerBottomLayer.entities.size() > 0)
-  {
-    registry.playerBottomLayer.remove(registry.playerBottomLayer.entities.back());
-  }
-
   while (registry.runAnimations.entities.size() > 0)
   {
     registry.runAnimations.remove(registry.runAnimations.entities.back());
@@ -1145,16 +943,14 @@ void WorldSystem::restart_game(int level)
   // Room dimensions
   const float roomWidth = WORLD_WIDTH_PX;
   const float roomHeight = WORLD_HEIGHT_PX;
-  const float wallThickness = 0.5f; // half-width for SetAsBox
 
-  // Create room boundaries
-  b2BodyId floorId = create_horizontal_wall(worldId, roomWidth / 2, 0.0f, roomWidth);          // Floor
-  b2BodyId ceilingId = create_horizontal_wall(worldId, roomWidth / 2, roomHeight, roomWidth);  // Ceiling
-  b2BodyId leftWallId = create_vertical_wall(worldId, 0.0f, roomHeight / 2, roomHeight);       // Left Wall
-  b2BodyId rightWallId = create_vertical_wall(worldId, roomWidth, roomHeight / 2, roomHeight); // Right Wall
+  // All level chains and the room boundaries share a single static body
+  create_static_terrain(worldId, roomWidth, roomHeight);
+  trajectory_preview.rebuild(roomWidth, roomHeight);
 
   createBackgroundLayer();
   createLevelTextureLayer(level_texture);
+  renderer->loadLevelArt(level_texture);
 
   // turn the tunes back on
   if (Mix_PausedMusic())
@@ -1351,27 +1147,10 @@ void WorldSystem::update_isGrounded()
 // call inside step() function for the most precise and responsive movement handling.
 void WorldSystem::handle_movement(float elapsed_ms)
 {
-
-  static float jumpCooldownTime = JUMP_COOLDOWN;
-  static float jumpCooldownTimer = 0.0f;
-
-  // first, update states.
-  int state = glfwGetKey(window, GLFW_KEY_E);
-
-  for (int i = 0; i < PLAYER_CONTROL_KEYS.size(); i++)
+  // first, update states. A replay already set them in begin_frame.
+  if (!input_log.replaying())
   {
-    int key = PLAYER_CONTROL_KEYS[i];
-    int action = glfwGetKey(window, key);
-
-    // set the keyState
-    if (action == GLFW_PRESS)
-    {
-      keyStates[key] = true;
-    }
-    else if (action == GLFW_RELEASE)
-    {
-      keyStates[key] = false;
-    }
+    poll_control_keys();
   }
 
   b2Vec2 nonjump_movement_force = {0, 0};
@@ -1438,17 +1217,17 @@ void WorldSystem::handle_movement(float elapsed_ms)
   }
 
   // jump is set seperately, since it can be used in conjunction with the movement keys.
-  if (keyStates[GLFW_KEY_SPACE] && jumpCooldownTimer <= 0.0f)
+  if (keyStates[GLFW_KEY_SPACE] && jump_cooldown_timer <= 0.0f)
 
   {
     // Jump: apply a strong upward impulse
     jump_impulse = {0, jumpImpulseMagnitude};
-    jumpCooldownTimer = jumpCooldownTime;
+    jump_cooldown_timer = JUMP_COOLDOWN;
   }
 
-  if (jumpCooldownTimer > 0.0f)
+  if (jump_cooldown_timer > 0.0f)
   {
-    jumpCooldownTimer -= (elapsed_ms / 1000.0f); // Decrease based on the time that has passed
+    jump_cooldown_timer -= (elapsed_ms / 1000.0f); // Decrease based on the time that has passed
   }
 
   // Apply impulse if non-zero.
@@ -1493,6 +1272,25 @@ void WorldSystem::handle_movement(float elapsed_ms)
   }
 }
 
+void WorldSystem::poll_control_keys()
+{
+  for (int i = 0; i < PLAYER_CONTROL_KEYS.size(); i++)
+  {
+    int key = PLAYER_CONTROL_KEYS[i];
+    int action = glfwGetKey(window, key);
+
+    // set the keyState
+    if (action == GLFW_PRESS)
+    {
+      keyStates[key] = true;
+    }
+    else if (action == GLFW_RELEASE)
+    {
+      keyStates[key] = false;
+    }
+  }
+}
+
 // on key callback
 void WorldSystem::on_key(int key, int scancode, int action, int mod)
 {
@@ -1516,6 +1314,33 @@ void WorldSystem::on_key(int key, int scancode, int action, int mod)
     currentScreen.current_screen = scoreboard_next_screen;
   }
 
+  // Toggle the segmented grapple rope (takes effect on the next grapple).
+  // Not while recording or replaying: the log only stores these toggles in its header.
+  if (action == GLFW_RELEASE && key == GLFW_KEY_G && input_log.mode() == InputLog::MODE::OFF)
+  {
+    GRAPPLE_ROPE_MODE = !GRAPPLE_ROPE_MODE;
+    std::cout << "Grapple rope mode " << (GRAPPLE_ROPE_MODE ? "on" : "off") << std::endl;
+  }
+
+  // Toggle swarm-vs-swarm contacts (compare the Contacts count in the window title)
+  if (action == GLFW_RELEASE && key == GLFW_KEY_K && input_log.mode() == InputLog::MODE::OFF)
+  {
+    SWARM_SWARM_CONTACTS = !SWARM_SWARM_CONTACTS;
+    b2Filter swarmFilter = collision_filter(CATEGORY_SWARM);
+    for (Entity entity : registry.enemies.entities)
+    {
+      if (registry.enemies.get(entity).enemyType != SWARM || !registry.physicsBodies.has(entity))
+        continue;
+
+      b2ShapeId shapeId;
+      if (b2Body_GetShapes(registry.physicsBodies.get(entity).bodyId, &shapeId, 1) > 0)
+      {
+        b2Shape_SetFilter(shapeId, swarmFilter);
+      }
+    }
+    std::cout << "Swarm-vs-swarm contacts " << (SWARM_SWARM_CONTACTS ? "on" : "off") << std::endl;
+  }
+
   // Reset game when R is released
 
   if (action == GLFW_RELEASE && key == GLFW_KEY_R)
@@ -1671,53 +1496,13 @@ void WorldSystem::on_mouse_button_pressed(int button, int action, int mods)
     // For the playing screen specifically, mouse controls grapple
     if (currentScreen.current_screen == "PLAYING")
     {
-      // Find the grapple point closest to the click that is within the threshold.
-      GrapplePoint *selectedGp = nullptr;
-      float bestDist = GRAPPLE_ATTACH_ZONE_RADIUS; // distance threshold
-
-      for (Entity gpEntity : registry.grapplePoints.entities)
-      {
-        GrapplePoint &gp = registry.grapplePoints.get(gpEntity);
-        float dist = length(gp.position - worldMousePos);
-        if (dist < bestDist)
-        {
-          bestDist = dist;
-          selectedGp = &gp;
-        }
-      }
-
-      // Deactivate all grapple enemies_killed.
-      for (Entity gpEntity : registry.grapplePoints.entities)
-      {
-        GrapplePoint &gp = registry.grapplePoints.get(gpEntity);
-        gp.active = false;
-      }
-
-      // If a valid grapple point is found, mark it as active.
-      if (selectedGp != nullptr)
-      {
-        selectedGp->active = true;
-        std::cout << "Selected grapple point at ("
-                  << selectedGp->position.x << ", " << selectedGp->position.y
-                  << ") with active = " << selectedGp->active << std::endl;
-      }
-
-      // Now, if no grapple is currently attached and we found an active point, attach the grapple.
-      if (!grappleActive && selectedGp != nullptr)
+      // a replay feeds its recorded clicks in begin_frame instead
+      if (input_log.replaying())
       {
-        shootGrapplePoint();
-      }
-      else if (!grappleActive && selectedGp == nullptr)
-      {
-        shootGrapple(worldMousePos);
-      }
-      else if (grappleActive)
-      {
-        playSoundEffect(FX::FX_GRAPPLE);
-        removeGrapple();
-        grappleActive = false;
-        grapplePointActive = false;
+        return;
       }
+      input_log.record_click(worldMousePos);
+      handleGrappleClick(worldMousePos);
     }
     // Every other screen, mouse deals with button presses.
     else
@@ -1819,6 +1604,57 @@ vec2 WorldSystem::screenToWorld(vec2 mouse_screen)
   return {0.f, 0.f}; // fallback if no camera
 }
 
+void WorldSystem::handleGrappleClick(vec2 worldMousePos)
+{
+  // Find the grapple point closest to the click that is within the threshold.
+  GrapplePoint *selectedGp = nullptr;
+  float bestDist = GRAPPLE_ATTACH_ZONE_RADIUS; // distance threshold
+
+  for (Entity gpEntity : registry.grapplePoints.entities)
+  {
+    GrapplePoint &gp = registry.grapplePoints.get(gpEntity);
+    float dist = length(gp.position - worldMousePos);
+    if (dist < bestDist)
+    {
+      bestDist = dist;
+      selectedGp = &gp;
+    }
+  }
+
+  // Deactivate all grapple enemies_killed.
+  for (Entity gpEntity : registry.grapplePoints.entities)
+  {
+    GrapplePoint &gp = registry.grapplePoints.get(gpEntity);
+    gp.active = false;
+  }
+
+  // If a valid grapple point is found, mark it as active.
+  if (selectedGp != nullptr)
+  {
+    selectedGp->active = true;
+    std::cout << "Selected grapple point at ("
+              << selectedGp->position.x << ", " << selectedGp->position.y
+              << ") with active = " << selectedGp->active << std::endl;
+  }
+
+  // Now, if no grapple is currently attached and we found an active point, attach the grapple.
+  if (!grappleActive && selectedGp != nullptr)
+  {
+    shootGrapplePoint();
+  }
+  else if (!grappleActive && selectedGp == nullptr)
+  {
+    shootGrapple(worldMousePos);
+  }
+  else if (grappleActive)
+  {
+    playSoundEffect(FX::FX_GRAPPLE);
+    removeGrapple();
+    grappleActive = false;
+    grapplePointActive = false;
+  }
+}
+
 void WorldSystem::shootGrapplePoint()
 {
   Entity playerEntity = registry.players.entities[0];
@@ -1862,7 +1698,7 @@ void WorldSystem::shootGrapplePoint()
   if (distance <= GRAPPLE_MAX_LENGTH)
   {
     playSoundEffect(FX::FX_GRAPPLE);
-    createGrapple(worldId, ballBodyId, activeGrappleBodyId, distance);
+    createGrapple(worldId, ballBodyId, vec2(grapplePos.x, grapplePos.y), distance);
     grappleActive = true;
     grapplePointActive = true;
   }
@@ -1883,7 +1719,7 @@ void WorldSystem::shootGrapple(vec2 worldMousePos)
   input.translation = rayDir;
   input.maxFraction = 1.0f;
 
-  b2RayResult result = b2World_CastRayClosest(worldId, ballPos, rayDir, b2DefaultQueryFilter());
+  b2RayResult result = b2World_CastRayClosest(worldId, ballPos, rayDir, grapple_query_filter());
 
   float distance = sqrtf((result.point.x - ballPos.x) * (result.point.x - ballPos.x) +
                          (result.point.y - ballPos.y) * (result.point.y - ballPos.y));
@@ -1894,18 +1730,70 @@ void WorldSystem::shootGrapple(vec2 worldMousePos)
     b2BodyType bodyType = b2Body_GetType(bodyId);
     if (bodyType == b2_staticBody)
     {
-      b2BodyDef bodyDef = b2DefaultBodyDef();
-      bodyDef.type = b2_staticBody;
-      bodyDef.position = b2Vec2{result.point.x, result.point.y};
-      b2BodyId bodyId = b2CreateBody(worldId, &bodyDef);
-
       playSoundEffect(FX::FX_GRAPPLE);
-      createGrapple(worldId, ballBodyId, bodyId, distance);
+      createGrapple(worldId, ballBodyId, vec2(result.point.x, result.point.y), distance);
       grappleActive = true;
     }
   }
 }
 
+void WorldSystem::updateTrajectoryPreview()
+{
+  // the arc lives on a single entity, created on demand
+  if (registry.trajectoryArcs.entities.empty())
+  {
+    registry.trajectoryArcs.emplace(Entity());
+  }
+  TrajectoryArc &arc = registry.trajectoryArcs.components[0];
+  arc.points.clear();
+
+  if (grappleActive || registry.players.entities.empty())
+  {
+    return;
+  }
+
+  Entity playerEntity = registry.players.entities[0];
+  b2BodyId ballBodyId = registry.physicsBodies.get(playerEntity).bodyId;
+  b2Vec2 ballPos = b2Body_GetPosition(ballBodyId);
+  vec2 worldMousePos = screenToWorld({mouse_pos_x, mouse_pos_y});
+
+  // Pick the anchor the same way a click would: grapple point near the cursor first, then terrain
+  bool hasAnchor = false;
+  vec2 anchor;
+  float bestDist = GRAPPLE_ATTACH_ZONE_RADIUS;
+  for (Entity gpEntity : registry.grapplePoints.entities)
+  {
+    GrapplePoint &gp = registry.grapplePoints.get(gpEntity);
+    float dist = length(gp.position - worldMousePos);
+    if (dist < bestDist)
+    {
+      bestDist = dist;
+      anchor = gp.position;
+      hasAnchor = true;
+    }
+  }
+  if (!hasAnchor)
+  {
+    b2Vec2 rayDir = b2Vec2{worldMousePos.x, worldMousePos.y} - ballPos;
+    b2RayResult result = b2World_CastRayClosest(worldId, ballPos, rayDir, grapple_query_filter());
+    if (result.hit)
+    {
+      anchor = vec2(result.point.x, result.point.y);
+      hasAnchor = true;
+    }
+  }
+
+  float distance = length(anchor - vec2(ballPos.x, ballPos.y));
+  if (!hasAnchor || distance > GRAPPLE_MAX_LENGTH)
+  {
+    return;
+  }
+
+  b2Vec2 ballVelocity = b2Body_GetLinearVelocity(ballBodyId);
+  arc.points = trajectory_preview.predict(vec2(ballPos.x, ballPos.y), vec2(ballVelocity.x, ballVelocity.y),
+                                          b2Body_GetAngularVelocity(ballBodyId), anchor, distance);
+}
+
 void WorldSystem::checkGrappleGrounded()
 {
   if (grappleActive)
@@ -1947,17 +1835,7 @@ void WorldSystem::checkGrappleGrounded()
 
 void WorldSystem::handleEnemySpawning(ENEMY_TYPES enemy_type, int quantity, ivec2 gridPosition, ivec2 grid_patrol_point_a, ivec2 grid_patrol_point_b)
 {
-  // Create specified number of enemies by iterating
-  for (int i = 0; i < quantity; i++)
-  {
-    createEnemy(
-        worldId,
-        vec2((gridPosition.x + 0.5 + 0.05 * i) * GRID_CELL_WIDTH_PX,
-             (gridPosition.y + 0.5) * GRID_CELL_HEIGHT_PX),
-        enemy_type,
-        vec2((grid_patrol_point_a.x + 0.5) * GRID_CELL_WIDTH_PX, (grid_patrol_point_a.y + 0.5) * GRID_CELL_HEIGHT_PX),
-        vec2((grid_patrol_point_b.x + 0.5) * GRID_CELL_WIDTH_PX, (grid_patrol_point_b.y + 0.5) * GRID_CELL_HEIGHT_PX));
-  }
+  createEnemyGroup(worldId, enemy_type, quantity, gridPosition, grid_patrol_point_a, grid_patrol_point_b);
 }
 
 // NOTE THAT ALL POSITIONS ARE GRID COORDINATES!!!
@@ -17,11 +17,8 @@
 #include <box2d/box2d.h>
 
 #include "render_system.hpp"
-#include <random>
-
-// Global Variables
-extern bool grapplePointActive; // Bool to check if grapple is on a grapple point
-extern bool grappleActive;		// Bool to check if grapple is active
+#include "trajectory_preview.hpp"
+#include "input_log.hpp"
 
 // Container for all our entities and game logic.
 // Individual rendering / updates are deferred to the update() methods.
@@ -50,6 +47,16 @@ public:
 	// steps the game ahead by ms milliseconds
 	bool step(float elapsed_ms);
 
+	// input record / replay (see input_log.hpp); both jump straight into the level
+	bool start_recording(const std::string &path, int level);
+	bool start_replay(const std::string &path);
+
+	// call before step(): logs or replays this tick's input, returns the frame time to simulate
+	float begin_frame(float elapsed_ms);
+
+	// render benchmark: load the level with every enemy group already spawned
+	bool start_bench_level(int level);
+
 	// check for collisions generated by the physics system
 	void handle_collisions(float elapsed_ms);
 
@@ -131,9 +138,13 @@ private:
 	void handle_movement(float elapsed_ms);
 	void update_isGrounded();
 
-	// C++ random number generator
-	std::default_random_engine rng;
-	std::uniform_real_distribution<float> uniform_dist; // number between 0..1
+	// reads PLAYER_CONTROL_KEYS into keyStates
+	void poll_control_keys();
+	float jump_cooldown_timer = 0.0f;
+
+	// input recording / replay
+	InputLog input_log;
+	bool start_logged_level(const InputLog::Header &header);
 
 	// input callback functions
 	void on_key(int key, int, int action, int mod);
@@ -180,13 +191,15 @@ private:
 		{9, {"lab.tmj", TEXTURE_ASSET_ID::LEVEL_LAB, MUSIC::COTTONPLANES}},
 		{10, {"under.tmj", TEXTURE_ASSET_ID::LEVEL_UNDER, MUSIC::SPABA}},
 		{11, {"snake.tmj", TEXTURE_ASSET_ID::LEVEL_SNAKE, MUSIC::PENCILCRAYONS}},
-		{12, {"tunnelsmall.tmj", TEXTURE_ASSET_ID::LEVEL_TUNNELSMALL, MUSIC::MOONTOWNSHORES}}
+		{12, {"tunnelsmall.tmj", TEXTURE_ASSET_ID::LEVEL_TUNNELSMALL, MUSIC::MOONTOWNSHORES}},
+		{13, {"tunnel.tmj", TEXTURE_ASSET_ID::LEVEL_TUNNEL, MUSIC::MOONTOWNSHORES}}
 
 				// How to Add Levels:
 				// 1. Add both TMJ (/levels) and PNG (/data/textures/levels) to the project
 				// 2. Add TMJ file, asset, and music here
 				// 3. Add ASSET_ID in components.hpp
-				// 4. Load map texture in render_system.hpp
+				// 4. Load map texture in render_system.hpp (level art is streamed, keep it inside isStreamedTexture)
+				//    and add it to LEVEL_ART in CMakeLists.txt so its tiles are cut
 	};
 
 	// NOTE THAT ALL POSITIONS ARE GRID COORDINATES!!!
@@ -280,6 +293,10 @@ private:
 	vec2 screenToWorld(vec2 mouse_position);
 	void checkGrappleGrounded();
 
+	// predicted swing if the grapple were shot at the cursor right now
+	TrajectoryPreview trajectory_preview;
+	void updateTrajectoryPreview();
+
 	// Starts the game at specified level
 	void levelHelper(int level, CurrentScreen &currentScreen);
 
@@ -299,6 +316,8 @@ private:
 
 	// Handles button presses based on the function of said button.
 	void handleButtonPress(Entity buttonEntity);
+	// Grapple to the point nearest the click, or along the click ray; a second click releases.
+	void handleGrappleClick(vec2 worldMousePos);
 	void shootGrapplePoint();
 	void shootGrapple(vec2 worldMousePos);
 	void updateScore(Entity scoreEntity);
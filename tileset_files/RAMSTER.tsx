@@ -0,0 +1,37 @@
+<?xml version="1.0" encoding="UTF-8"?>
+<tileset version="1.10" tiledversion="1.10.2" name="RAMSTER" tilewidth="128" tileheight="128" tilecount="11" columns="0">
+ <grid orientation="orthogonal" width="1" height="1"/>
+ <tile id="1">
+  <image width="128" height="128" source="../data/textures/tiles/half-square-2-bottom.png"/>
+ </tile>
+ <tile id="2">
+  <image width="128" height="128" source="../data/textures/tiles/square-tile-2.png"/>
+ </tile>
+ <tile id="10">
+  <image width="128" height="128" source="../data/textures/tiles/half-ramp-br.png"/>
+ </tile>
+ <tile id="12">
+  <image width="128" height="128" source="../data/textures/tiles/smooth-ramp-br.png"/>
+ </tile>
+ <tile id="15">
+  <image width="128" height="128" source="../data/textures/tiles/square-tile-1.png"/>
+ </tile>
+ <tile id="16">
+  <image width="128" height="128" source="../data/textures/tiles/half-square-left.png"/>
+ </tile>
+ <tile id="33">
+  <image width="128" height="128" source="../data/textures/tiles/smooth-ramp-tr.png"/>
+ </tile>
+ <tile id="47">
+  <image width="128" height="128" source="../data/textures/tiles/smooth-ramp-bl.png"/>
+ </tile>
+ <tile id="65">
+  <image width="128" height="128" source="../data/textures/tiles/tesla-trap-1-bottom.png"/>
+ </tile>
+ <tile id="70">
+  <image width="128" height="128" source="../data/textures/tiles/smooth-ramp-tl.png"/>
+ </tile>
+ <tile id="213">
+  <image width="128" height="128" source="../data/textures/tiles/half-ramp-br.png"/>
+ </tile>
+</tileset>
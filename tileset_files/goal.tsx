@@ -0,0 +1,10 @@
+<?xml version="1.0" encoding="UTF-8"?>
+<tileset version="1.10" tiledversion="1.10.2" name="goal" tilewidth="128" tileheight="128" tilecount="2" columns="0">
+ <grid orientation="orthogonal" width="1" height="1"/>
+ <tile id="0">
+  <image width="128" height="128" source="../data/textures/tiles/goal-line.png"/>
+ </tile>
+ <tile id="1">
+  <image width="128" height="128" source="../data/textures/tiles/goal-flag.png"/>
+ </tile>
+</tileset>
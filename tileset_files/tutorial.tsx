@@ -0,0 +1,10 @@
+<?xml version="1.0" encoding="UTF-8"?>
+<tileset version="1.10" tiledversion="1.10.2" name="tutorial" tilewidth="384" tileheight="128" tilecount="2" columns="0">
+ <grid orientation="orthogonal" width="1" height="1"/>
+ <tile id="2">
+  <image width="384" height="128" source="../data/textures/tiles/tutorial-arrow.png"/>
+ </tile>
+ <tile id="11">
+  <image width="256" height="128" source="../data/textures/tiles/tutorial-mission.png"/>
+ </tile>
+</tileset>
@@ -0,0 +1,360 @@
+// Level art splitter (target: ramster_split_level_art, run by the level_art_tiles target).
+//
+// Cuts a level image into the tile files LevelTileCache streams from: one png per cache slot,
+// SLOT_SIZE square with the PADDING texels of the neighbouring tiles already in, plus a
+// tiles.json manifest with the image size. The game then never decodes a whole level image;
+// this tool does, once, when the art changes.
+//
+//   ramster_split_level_art IMAGE.png [IMAGE.png ...]
+//
+// The tiles of levels/foo.png go to levels/tiles/foo/ (LevelTileCache::tile_directory). The
+// directory is emptied first and the manifest written last, so a run that stops half way
+// leaves a level the game reports as missing rather than one with stale tiles.
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../ext/stb_image/stb_image.h"
+
+#include <json/json.h>
+
+// stdlib
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// internal
+#include "level_tiles.hpp"
+
+// stb_image only reads png, so the tiles are written here: deflate with the fixed Huffman codes
+// and a hash-chain match finder. Level art is mostly flat colour and empty sky, which long
+// matches alone compress well.
+class BitWriter
+{
+public:
+	explicit BitWriter(std::vector<uint8_t> &out) : out(out) {}
+
+	// n bits of value, least significant first
+	void put(uint32_t value, int n)
+	{
+		bits |= value << count;
+		count += n;
+		while (count >= 8) {
+			out.push_back((uint8_t)(bits & 0xff));
+			bits >>= 8;
+			count -= 8;
+		}
+	}
+
+	void flush()
+	{
+		if (count > 0) {
+			out.push_back((uint8_t)(bits & 0xff));
+		}
+		bits = 0;
+		count = 0;
+	}
+
+private:
+	std::vector<uint8_t> &out;
+	uint32_t bits = 0;
+	int count = 0;
+};
+
+// Huffman codes go out most significant bit first
+static uint32_t reverse_bits(uint32_t code, int n)
+{
+	uint32_t reversed = 0;
+	for (int i = 0; i < n; i++) {
+		reversed = (reversed << 1) | (code & 1);
+		code >>= 1;
+	}
+	return reversed;
+}
+
+static void put_symbol(BitWriter &writer, int symbol)
+{
+	if (symbol < 144) {
+		writer.put(reverse_bits(0x30 + symbol, 8), 8);
+	}
+	else if (symbol < 256) {
+		writer.put(reverse_bits(0x190 + symbol - 144, 9), 9);
+	}
+	else if (symbol < 280) {
+		writer.put(reverse_bits(symbol - 256, 7), 7);
+	}
+	else {
+		writer.put(reverse_bits(0xc0 + symbol - 280, 8), 8);
+	}
+}
+
+static void put_match(BitWriter &writer, int length, int distance)
+{
+	static const int LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static const int LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static const int DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static const int DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	int l = 28;
+	while (LENGTH_BASE[l] > length) {
+		l--;
+	}
+	put_symbol(writer, 257 + l);
+	writer.put(length - LENGTH_BASE[l], LENGTH_EXTRA[l]);
+
+	int d = 29;
+	while (DISTANCE_BASE[d] > distance) {
+		d--;
+	}
+	writer.put(reverse_bits(d, 5), 5);
+	writer.put(distance - DISTANCE_BASE[d], DISTANCE_EXTRA[d]);
+}
+
+static std::vector<uint8_t> zlib_compress(const std::vector<uint8_t> &data)
+{
+	const int WINDOW = 32768;
+	const int HASH_SIZE = 1 << 15;
+	const int MAX_CHAIN = 32;
+	const int MIN_MATCH = 3;
+	const int MAX_MATCH = 258;
+
+	std::vector<uint8_t> out = { 0x78, 0x01 };
+	BitWriter writer(out);
+	writer.put(1, 1); // final block
+	writer.put(1, 2); // fixed Huffman codes
+
+	const int n = (int)data.size();
+	std::vector<int> head(HASH_SIZE, -1);
+	std::vector<int> previous(WINDOW, -1);
+	auto hash_at = [&](int i) {
+		return (int)(((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) & (HASH_SIZE - 1));
+	};
+	auto insert = [&](int i) {
+		if (i + MIN_MATCH > n) {
+			return;
+		}
+		const int h = hash_at(i);
+		previous[i % WINDOW] = head[h];
+		head[h] = i;
+	};
+
+	int i = 0;
+	while (i < n) {
+		int best_length = 0;
+		int best_distance = 0;
+		if (i + MIN_MATCH <= n) {
+			const int max_length = std::min(MAX_MATCH, n - i);
+			int candidate = head[hash_at(i)];
+			for (int chain = 0; chain < MAX_CHAIN && candidate >= 0 && i - candidate <= WINDOW; chain++) {
+				int length = 0;
+				while (length < max_length && data[candidate + length] == data[i + length]) {
+					length++;
+				}
+				if (length > best_length) {
+					best_length = length;
+					best_distance = i - candidate;
+					if (length == max_length) {
+						break;
+					}
+				}
+				const int next = previous[candidate % WINDOW];
+				if (next >= candidate) {
+					break; // the slot was reused by a newer position
+				}
+				candidate = next;
+			}
+		}
+
+		if (best_length >= MIN_MATCH) {
+			put_match(writer, best_length, best_distance);
+			for (int k = 0; k < best_length; k++) {
+				insert(i + k);
+			}
+			i += best_length;
+		}
+		else {
+			put_symbol(writer, data[i]);
+			insert(i);
+			i++;
+		}
+	}
+	put_symbol(writer, 256);
+	writer.flush();
+
+	uint32_t a = 1, b = 0;
+	for (uint8_t byte : data) {
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	const uint32_t adler = (b << 16) | a;
+	for (int shift = 24; shift >= 0; shift -= 8) {
+		out.push_back((uint8_t)(adler >> shift));
+	}
+	return out;
+}
+
+static uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0)
+{
+	static uint32_t table[256];
+	static bool table_ready = false;
+	if (!table_ready) {
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++) {
+				c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			}
+			table[i] = c;
+		}
+		table_ready = true;
+	}
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++) {
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static void put_u32(std::vector<uint8_t> &out, uint32_t value)
+{
+	for (int shift = 24; shift >= 0; shift -= 8) {
+		out.push_back((uint8_t)(value >> shift));
+	}
+}
+
+static void put_chunk(std::vector<uint8_t> &out, const char *type, const std::vector<uint8_t> &data)
+{
+	put_u32(out, (uint32_t)data.size());
+	const size_t start = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), data.begin(), data.end());
+	put_u32(out, crc32(out.data() + start, out.size() - start));
+}
+
+// Paeth predictor from the png spec
+static uint8_t paeth(int a, int b, int c)
+{
+	const int p = a + b - c;
+	const int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+	if (pa <= pb && pa <= pc) {
+		return (uint8_t)a;
+	}
+	return (uint8_t)(pb <= pc ? b : c);
+}
+
+// RGBA8 png of an image whose rows are stored bottom up, like everything stbi loads for the game.
+// Each row takes the filter with the smallest sum of absolute residuals.
+static bool write_png(const std::string &path, const uint8_t *pixels, ivec2 size)
+{
+	const size_t stride = (size_t)size.x * 4;
+	std::vector<uint8_t> scanlines;
+	scanlines.reserve((stride + 1) * size.y);
+	std::vector<uint8_t> candidate(stride);
+	std::vector<uint8_t> best(stride);
+	const std::vector<uint8_t> empty_row(stride, 0);
+	for (int y = 0; y < size.y; y++) {
+		const uint8_t *row = pixels + (size_t)(size.y - 1 - y) * stride;
+		const uint8_t *up = y > 0 ? pixels + (size_t)(size.y - y) * stride : empty_row.data();
+
+		long best_cost = -1;
+		uint8_t best_filter = 0;
+		for (uint8_t filter = 0; filter < 5; filter++) {
+			long cost = 0;
+			for (size_t x = 0; x < stride; x++) {
+				const int left = x >= 4 ? row[x - 4] : 0;
+				const int up_left = x >= 4 ? up[x - 4] : 0;
+				uint8_t predicted = 0;
+				switch (filter) {
+				case 1: predicted = (uint8_t)left; break;
+				case 2: predicted = up[x]; break;
+				case 3: predicted = (uint8_t)((left + up[x]) / 2); break;
+				case 4: predicted = paeth(left, up[x], up_left); break;
+				}
+				candidate[x] = (uint8_t)(row[x] - predicted);
+				cost += abs((int8_t)candidate[x]);
+			}
+			if (best_cost < 0 || cost < best_cost) {
+				best_cost = cost;
+				best_filter = filter;
+				best.swap(candidate);
+			}
+		}
+		scanlines.push_back(best_filter);
+		scanlines.insert(scanlines.end(), best.begin(), best.end());
+	}
+
+	std::vector<uint8_t> header;
+	put_u32(header, (uint32_t)size.x);
+	put_u32(header, (uint32_t)size.y);
+	header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8 bit RGBA, no interlace
+
+	std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	put_chunk(png, "IHDR", header);
+	put_chunk(png, "IDAT", zlib_compress(scanlines));
+	put_chunk(png, "IEND", {});
+
+	std::ofstream file(path, std::ios::binary);
+	file.write((const char *)png.data(), (std::streamsize)png.size());
+	return (bool)file;
+}
+
+static bool split_image(const std::string &image_path)
+{
+	ivec2 size;
+	stbi_uc *pixels = stbi_load(image_path.c_str(), &size.x, &size.y, NULL, 4);
+	if (pixels == NULL) {
+		std::cerr << "split_level_art: could not load " << image_path << std::endl;
+		return false;
+	}
+
+	const std::string directory = LevelTileCache::tile_directory(image_path);
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+
+	const int tile_size = LevelTileCache::TILE_SIZE;
+	const ivec2 tile_count = (size + ivec2(tile_size - 1)) / tile_size;
+	std::vector<uint8_t> slot;
+	bool ok = true;
+	for (int ty = 0; ty < tile_count.y && ok; ty++) {
+		for (int tx = 0; tx < tile_count.x && ok; tx++) {
+			LevelTileCache::cut_slot(pixels, size, ivec2(tx, ty), slot);
+			ok = write_png(LevelTileCache::tile_path(directory, ivec2(tx, ty)), slot.data(), ivec2(LevelTileCache::SLOT_SIZE));
+		}
+	}
+	stbi_image_free(pixels);
+	if (!ok) {
+		std::cerr << "split_level_art: could not write the tiles of " << image_path << std::endl;
+		return false;
+	}
+
+	Json::Value manifest;
+	manifest["width"] = size.x;
+	manifest["height"] = size.y;
+	manifest["tile_size"] = tile_size;
+	manifest["padding"] = LevelTileCache::PADDING;
+	std::ofstream file(LevelTileCache::manifest_path(directory));
+	file << manifest << std::endl;
+
+	std::cout << "split_level_art: " << image_path << " (" << size.x << "x" << size.y << ") -> "
+			  << tile_count.x * tile_count.y << " tiles in " << directory << std::endl;
+	return (bool)file;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		std::cerr << "usage: ramster_split_level_art IMAGE.png [IMAGE.png ...]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// rows bottom up, as the game loads them
+	stbi_set_flip_vertically_on_load(true);
+
+	bool ok = true;
+	for (int i = 1; i < argc; i++) {
+		ok = split_image(argv[i]) && ok;
+	}
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}